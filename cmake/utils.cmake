@@ -1,4 +1,4 @@
-set(SUBPROJECT_DEPENDENCIES "xdg-shell")
+set(SUBPROJECT_DEPENDENCIES "xdg-shell" "cursor-shape-v1" "relative-pointer-unstable-v1")
 if (PROJECT_IS_TOP_LEVEL)
 	set(VENDORS_DIR ${PROJECT_SOURCE_DIR}/vendors)
 else()
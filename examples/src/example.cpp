@@ -1,7 +1,11 @@
 #include <cstdlib>
 #include <print>
+#include <variant>
+
+#include <linux/input-event-codes.h>
 
 #include <liteway/error.hpp>
+#include <liteway/event.hpp>
 #include <liteway/janitor.hpp>
 #include <liteway/wayland/instance.hpp>
 #include <liteway/wayland/window.hpp>
@@ -22,7 +26,6 @@ auto run() noexcept -> lw::Failable<void> {
 	})};
 	if (!windowWithError)
 		return lw::pushToErrorStack(windowWithError, "Can't create liteway window");
-	[[maybe_unused]]
 	auto& window {*windowWithError};
 
 	bool running {true};
@@ -30,6 +33,20 @@ auto run() noexcept -> lw::Failable<void> {
 		lw::Failable litewayUpdateResult {instance.update()};
 		if (!litewayUpdateResult) [[unlikely]]
 			return lw::pushToErrorStack(litewayUpdateResult, "Can't update liteway");
+		while (const auto event {instance.pollEvent()}) {
+			const auto* keyEvent {std::get_if<lw::KeyEvent> (&*event)};
+			if (keyEvent != nullptr && keyEvent->key == KEY_ESC && keyEvent->state == lw::KeyState::pressed)
+				running = false;
+		}
+		if (window.isFramePending())
+			continue;
+
+		lw::Failable fillResult {window.fill({.r = 0, .g = 0, .b = 0, .a = 170})};
+		if (!fillResult) [[unlikely]]
+			return lw::pushToErrorStack(fillResult, "Can't fill liteway window");
+		lw::Failable presentResult {window.present()};
+		if (!presentResult) [[unlikely]]
+			return lw::pushToErrorStack(presentResult, "Can't present liteway window");
 	}
 	return {};
 }
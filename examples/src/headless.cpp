@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <print>
+
+#include <liteway/backend.hpp>
+#include <liteway/error.hpp>
+#include <liteway/instance.hpp>
+#include <liteway/window.hpp>
+
+
+auto run() noexcept -> lw::Failable<void> {
+	using Backend = lw::backends::Headless;
+	constexpr std::uint32_t frameCount {1000};
+
+	lw::Failable instanceWithError {lw::Instance<Backend>::create({
+		.frameRate = 0
+	})};
+	if (!instanceWithError)
+		return lw::pushToErrorStack(instanceWithError, "Can't create liteway instance");
+	auto& instance {*instanceWithError};
+
+	lw::Failable windowWithError {lw::Window<Backend>::create({
+		.instance = instance,
+		.title = "liteway",
+		.width = 1920, .height = 1080
+	})};
+	if (!windowWithError)
+		return lw::pushToErrorStack(windowWithError, "Can't create liteway window");
+	auto& window {*windowWithError};
+
+	const auto start {std::chrono::steady_clock::now()};
+	for (std::uint32_t frame {0}; frame < frameCount; ++frame) {
+		lw::Failable litewayUpdateResult {instance.update()};
+		if (!litewayUpdateResult) [[unlikely]]
+			return lw::pushToErrorStack(litewayUpdateResult, "Can't update liteway");
+
+		const auto shade {static_cast<std::uint8_t> (frame)};
+		lw::Failable fillResult {window.fill({.r = shade, .g = shade, .b = shade, .a = 255})};
+		if (!fillResult) [[unlikely]]
+			return lw::pushToErrorStack(fillResult, "Can't fill liteway window");
+		lw::Failable presentResult {window.present()};
+		if (!presentResult) [[unlikely]]
+			return lw::pushToErrorStack(presentResult, "Can't present liteway window");
+	}
+	const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+	std::println("{} frames in {:.3f}s, {:.1f} frames per second", frameCount, elapsed.count(),
+		frameCount / elapsed.count()
+	);
+	return {};
+}
+
+auto main(int, char**) -> int {
+	lw::Failable runResult {run()};
+	if (runResult)
+		return EXIT_SUCCESS;
+	runResult.error().print(stderr);
+	return EXIT_FAILURE;
+}
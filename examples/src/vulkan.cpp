@@ -0,0 +1,111 @@
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <print>
+#include <variant>
+#include <vector>
+
+#include <linux/input-event-codes.h>
+
+#include <liteway/error.hpp>
+#include <liteway/event.hpp>
+#include <liteway/janitor.hpp>
+#include <liteway/wayland/instance.hpp>
+#include <liteway/wayland/vulkan.hpp>
+#include <liteway/wayland/window.hpp>
+
+
+/*
+ * Presents a natively presented window through Vulkan without any GPU by running it on Mesa's lavapipe :
+ * VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./liteway-example-vulkan
+ *
+ * This is the only check of `createVulkanSurface` and there is no CTest target for it: liteway has no test setup, and
+ * such a test would have to be skipped anywhere without both an ICD and a compositor, which is most CI machines. To
+ * run it without a display, start `weston --backend=headless --socket=liteway-test` and run the example with
+ * `WAYLAND_DISPLAY=liteway-test`. `createEglWindow` has no example yet, an EGL program can check it the same way with
+ * `LIBGL_ALWAYS_SOFTWARE=1` to run on llvmpipe
+ */
+auto run() noexcept -> lw::Failable<void> {
+	lw::Failable instanceWithError {lw::wayland::Instance::create({})};
+	if (!instanceWithError)
+		return lw::pushToErrorStack(instanceWithError, "Can't create liteway instance");
+	auto& instance {*instanceWithError};
+
+	lw::Failable windowWithError {lw::wayland::Window::create({
+		.instance = instance,
+		.title = "liteway vulkan",
+		.width = 16*70, .height = 9*70,
+		.presentation = lw::wayland::Window::Presentation::native
+	})};
+	if (!windowWithError)
+		return lw::pushToErrorStack(windowWithError, "Can't create liteway window");
+	auto& window {*windowWithError};
+
+	const std::array extensions {VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME};
+	const VkApplicationInfo applicationInfos {
+		.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+		.pNext = nullptr,
+		.pApplicationName = "liteway vulkan",
+		.applicationVersion = 0,
+		.pEngineName = "liteway",
+		.engineVersion = 0,
+		.apiVersion = VK_API_VERSION_1_0
+	};
+	const VkInstanceCreateInfo vulkanInstanceCreateInfos {
+		.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.pApplicationInfo = &applicationInfos,
+		.enabledLayerCount = 0,
+		.ppEnabledLayerNames = nullptr,
+		.enabledExtensionCount = static_cast<std::uint32_t> (extensions.size()),
+		.ppEnabledExtensionNames = extensions.data()
+	};
+	VkInstance vulkanInstance {VK_NULL_HANDLE};
+	if (vkCreateInstance(&vulkanInstanceCreateInfos, nullptr, &vulkanInstance) != VK_SUCCESS)
+		return lw::makeErrorStack("Can't create vulkan instance");
+	lw::Janitor instanceJanitor {[vulkanInstance]() noexcept {vkDestroyInstance(vulkanInstance, nullptr);}};
+
+	lw::Failable surfaceWithError {lw::wayland::createVulkanSurface(window, vulkanInstance)};
+	if (!surfaceWithError)
+		return lw::pushToErrorStack(surfaceWithError, "Can't create vulkan surface of liteway window");
+	const VkSurfaceKHR surface {*surfaceWithError};
+	lw::Janitor surfaceJanitor {[vulkanInstance, surface]() noexcept {
+		vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
+	}};
+
+	std::uint32_t physicalDeviceCount {};
+	(void)vkEnumeratePhysicalDevices(vulkanInstance, &physicalDeviceCount, nullptr);
+	std::vector<VkPhysicalDevice> physicalDevices (physicalDeviceCount);
+	(void)vkEnumeratePhysicalDevices(vulkanInstance, &physicalDeviceCount, physicalDevices.data());
+	for (VkPhysicalDevice physicalDevice : physicalDevices) {
+		VkPhysicalDeviceProperties properties {};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		VkBool32 isSupported {VK_FALSE};
+		(void)vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, 0, surface, &isSupported);
+		std::println("{} : can present to the window from queue family 0 : {}",
+			properties.deviceName, isSupported == VK_TRUE
+		);
+	}
+
+	bool running {true};
+	while (running) {
+		lw::Failable litewayUpdateResult {instance.update()};
+		if (!litewayUpdateResult) [[unlikely]]
+			return lw::pushToErrorStack(litewayUpdateResult, "Can't update liteway");
+		while (const auto event {instance.pollEvent()}) {
+			const auto* keyEvent {std::get_if<lw::KeyEvent> (&*event)};
+			if (keyEvent != nullptr && keyEvent->key == KEY_ESC && keyEvent->state == lw::KeyState::pressed)
+				running = false;
+		}
+	}
+	return {};
+}
+
+auto main(int, char**) -> int {
+	lw::Failable runResult {run()};
+	if (runResult)
+		return EXIT_SUCCESS;
+	runResult.error().print(stderr);
+	return EXIT_FAILURE;
+}
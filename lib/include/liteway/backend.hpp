@@ -0,0 +1,68 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/headless/instance.hpp"
+#include "liteway/headless/window.hpp"
+#include "liteway/image.hpp"
+#include "liteway/input.hpp"
+#include "liteway/memory.hpp"
+#include "liteway/wayland/instance.hpp"
+#include "liteway/wayland/window.hpp"
+
+
+namespace lw {
+	template <typename T>
+	concept InstanceBackend = std::movable<T> && requires(T instance, const T constInstance) {
+		typename T::CreateInfos;
+		{T::create(std::declval<typename T::CreateInfos&&> ())} -> std::same_as<lw::Failable<T>>;
+		{instance.update()} -> std::same_as<lw::Failable<void>>;
+		{instance.flush()} -> std::same_as<lw::Failable<void>>;
+		{instance.pollEvent()} -> std::same_as<std::optional<lw::Event>>;
+		{constInstance.getInputState()} -> std::same_as<lw::InputState>;
+		{constInstance.getMemoryStatistics()} -> std::same_as<lw::MemoryStatistics>;
+	};
+
+	template <typename T>
+	concept WindowBackend = std::movable<T>
+		&& requires(T window, const T constWindow, const lw::Color& color, lw::CursorShape shape) {
+			typename T::CreateInfos;
+			{constWindow.getId()} -> std::same_as<lw::WindowId>;
+			{constWindow.getWidth()} -> std::same_as<std::uint32_t>;
+			{constWindow.getHeight()} -> std::same_as<std::uint32_t>;
+			{window.getBackBuffer()} -> std::same_as<lw::Failable<lw::ImageView>>;
+			{window.fill(color)} -> std::same_as<lw::Failable<void>>;
+			{window.present()} -> std::same_as<lw::Failable<void>>;
+			{constWindow.isFramePending()} -> std::same_as<bool>;
+			{window.trim()} -> std::same_as<void>;
+			{constWindow.getMemoryStatistics()} -> std::same_as<lw::MemoryStatistics>;
+			{window.setCursorShape(shape)} -> std::same_as<lw::Failable<void>>;
+		};
+
+	/// A backend is a tag type naming the instance and window classes implementing it
+	template <typename B>
+	concept Backend = InstanceBackend<typename B::Instance> && WindowBackend<typename B::Window>;
+
+
+	namespace backends {
+		struct Wayland {
+			using Instance = lw::wayland::Instance;
+			using Window = lw::wayland::Window;
+		};
+
+		struct Headless {
+			using Instance = lw::headless::Instance;
+			using Window = lw::headless::Window;
+		};
+	}
+
+	static_assert(lw::Backend<lw::backends::Wayland>);
+	static_assert(lw::Backend<lw::backends::Headless>);
+}
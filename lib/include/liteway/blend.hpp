@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "liteway/color.hpp"
+#include "liteway/export.hpp"
+
+
+namespace lw {
+	/*
+	 * Blends `color`, scaled by a coverage mask, over premultiplied ARGB8888 pixels. The color isn't premultiplied.
+	 * Uses AVX2 or SSE2 when the CPU has them, every kernel gives bit-identical results
+	 */
+	LW_EXPORT auto blendCoverage(
+		std::span<std::uint32_t> destination,
+		std::span<const std::uint8_t> coverage,
+		const lw::Color& color
+	) noexcept -> void;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace lw {
+	enum class CursorShape : std::uint8_t {
+		arrow,
+		contextMenu,
+		help,
+		pointer,
+		progress,
+		wait,
+		cell,
+		crosshair,
+		text,
+		verticalText,
+		alias,
+		copy,
+		move,
+		noDrop,
+		notAllowed,
+		grab,
+		grabbing,
+		resizeEast,
+		resizeNorth,
+		resizeNorthEast,
+		resizeNorthWest,
+		resizeSouth,
+		resizeSouthEast,
+		resizeSouthWest,
+		resizeWest,
+		resizeEastWest,
+		resizeNorthSouth,
+		resizeNorthEastSouthWest,
+		resizeNorthWestSouthEast,
+		resizeColumn,
+		resizeRow,
+		allScroll,
+		zoomIn,
+		zoomOut,
+		hidden,
+
+		count
+	};
+
+	constexpr std::size_t cursorShapeCount {static_cast<std::size_t> (CursorShape::count)};
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "liteway/error.hpp"
+#include "liteway/export.hpp"
+#include "liteway/image.hpp"
+#include "liteway/pointer.hpp"
+
+
+namespace lw {
+	enum class ImageFormat : std::uint8_t {
+		/// Quite OK Image format
+		qoi,
+		/// Binary PPM, `P6`, with up to 8 bits per channel
+		ppm
+	};
+
+	struct ImageInfos {
+		lw::ImageFormat format;
+		std::uint32_t width;
+		std::uint32_t height;
+	};
+
+
+	/*
+	 * Decodes an mmapped QOI or PPM file straight into premultiplied ARGB8888 rows, typically those of a window's back
+	 * buffer, without allocating the image anywhere else. Rows are decoded in order and can be asked for in batches
+	 */
+	class LW_EXPORT ImageDecoder final {
+		public:
+			ImageDecoder(const ImageDecoder&) = delete;
+			auto operator=(const ImageDecoder&) = delete;
+
+			inline ImageDecoder() noexcept = default;
+			inline ImageDecoder(ImageDecoder&&) noexcept = default;
+			auto operator=(ImageDecoder&& other) noexcept -> ImageDecoder&;
+			~ImageDecoder();
+
+			struct CreateInfos {
+				/// Opened if `fd` is -1
+				std::string_view path {};
+				/// Must be a regular file, it isn't closed and can be once the decoder is created
+				int fd {-1};
+			};
+
+			static auto create(const CreateInfos& createInfos) noexcept -> lw::Failable<ImageDecoder>;
+
+			[[nodiscard]]
+			auto getInfos() const noexcept -> ImageInfos;
+			[[nodiscard]]
+			auto getDecodedRowCount() const noexcept -> std::uint32_t;
+			/*
+			 * Decodes the next rows into the rows of `destination`, as many as it has and the image still has.
+			 * `destination` must be at least as wide as the image. Returns the amount of rows decoded. Once a row fails,
+			 * every later call fails too
+			 */
+			auto decodeRows(const lw::ImageView& destination) noexcept -> lw::Failable<std::uint32_t>;
+
+		private:
+			/// QOI pixels in memory order, red first
+			using Rgba = std::array<std::uint8_t, 4>;
+
+			struct QoiState {
+				std::array<Rgba, 64> index;
+				Rgba previous;
+				/// Repeats of `previous` left before the next chunk
+				std::uint32_t run;
+			};
+
+			auto decodeQoiRow(std::span<std::uint32_t> row) noexcept -> lw::Failable<void>;
+			auto decodePpmRow(std::span<std::uint32_t> row) noexcept -> lw::Failable<void>;
+
+			lw::OwnedSpan<std::byte> m_file;
+			ImageInfos m_infos {};
+			/// Offset of the first byte of `m_file` that isn't decoded yet
+			std::size_t m_position {0};
+			std::uint32_t m_decodedRowCount {0};
+			std::uint32_t m_maxValue {0};
+			QoiState m_qoi {};
+			bool m_hasFailed {false};
+	};
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+
+namespace lw {
+	enum class WindowId : std::uint32_t {};
+
+	enum class KeyState : std::uint8_t {
+		released,
+		pressed,
+		repeated
+	};
+
+	/*
+	 * Timestamps are in nanoseconds of `CLOCK_MONOTONIC`, taken when liteway dispatches the compositor's event.
+	 * Repeats get the time they were scheduled at, counted from their press
+	 */
+	struct KeyEvent {
+		lw::WindowId window;
+		/// Linux evdev scancode, as found in `linux/input-event-codes.h`
+		std::uint32_t key;
+		lw::KeyState state;
+		std::uint64_t timestamp;
+	};
+
+	/*
+	 * Unless the instance keeps the pointer motion history, every motion that happened since the last poll of the
+	 * same window is merged into a single event holding the last position and the summed deltas
+	 */
+	struct PointerMotionEvent {
+		lw::WindowId window;
+		/// Surface local position
+		double x;
+		double y;
+		double deltaX;
+		double deltaY;
+		/// Deltas before pointer acceleration, always 0 if the compositor doesn't support relative pointers
+		double unacceleratedDeltaX;
+		double unacceleratedDeltaY;
+		/// Amount of compositor motion events merged into this one
+		std::uint32_t motionCount;
+		/// Nanoseconds of `CLOCK_MONOTONIC`, taken when liteway dispatches the last merged motion, like `KeyEvent`'s
+		std::uint64_t timestamp;
+	};
+
+	/// The clipboard content changed, `mimeTypes` is empty when it was cleared
+	struct ClipboardEvent {
+		std::vector<std::string> mimeTypes;
+	};
+
+	enum class DragState : std::uint8_t {
+		entered,
+		moved,
+		left,
+		dropped
+	};
+
+	/// Another client drags something over a window. The offered MIME types are only given when it enters
+	struct DragEvent {
+		lw::WindowId window;
+		lw::DragState state;
+		/// Surface local position
+		double x;
+		double y;
+		std::vector<std::string> mimeTypes;
+	};
+
+	enum class TransferId : std::uint32_t {};
+
+	enum class TransferState : std::uint8_t {
+		completed,
+		failed
+	};
+
+	/// Sent once a clipboard or drag and drop transfer is over, in either direction
+	struct TransferEvent {
+		lw::TransferId transfer;
+		lw::TransferState state;
+		/// Bytes moved through the transfer
+		std::uint64_t size;
+	};
+
+	using Event = std::variant<
+		lw::KeyEvent,
+		lw::PointerMotionEvent,
+		lw::ClipboardEvent,
+		lw::DragEvent,
+		lw::TransferEvent
+	>;
+}
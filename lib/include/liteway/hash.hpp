@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+#include "liteway/export.hpp"
+#include "liteway/image.hpp"
+
+
+namespace lw {
+	/*
+	 * Non-cryptographic 64 bits hash of the pixels of an image, its stride excluded, meant to tell whether it changed.
+	 * Uses AVX2 or SSE2 when the CPU has them, every kernel gives the same hash
+	 */
+	LW_EXPORT auto hashImage(const lw::ImageView& image) noexcept -> std::uint64_t;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/export.hpp"
+#include "liteway/input.hpp"
+#include "liteway/memory.hpp"
+
+
+namespace lw::headless {
+	namespace internals {
+		struct WindowState;
+
+		struct InstanceState {
+			/// 0 means frames are never throttled
+			std::uint64_t frameInterval;
+			std::uint64_t nextFrameTimestamp;
+			std::uint32_t nextWindowId;
+			std::deque<lw::Event> events;
+			std::vector<WindowState*> windows;
+			lw::MemoryStatistics memoryStatistics;
+		};
+	}
+
+
+	/*
+	 * Backend without any compositor, windows render into plain memory and frame callbacks are simulated at a fixed
+	 * rate. Useful to run rendering pipelines and benchmarks on servers
+	 */
+	class LW_EXPORT Instance {
+		friend class Window;
+		public:
+			Instance(const Instance&) = delete;
+			auto operator=(const Instance&) = delete;
+
+			inline Instance() noexcept = default;
+			inline Instance(Instance&&) noexcept = default;
+			inline auto operator=(Instance&&) noexcept -> Instance& = default;
+			~Instance();
+
+			struct CreateInfos {
+				/// Simulated frame callbacks per second, 0 completes them as soon as `update` is called
+				std::uint32_t frameRate {60};
+			};
+
+			static auto create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance>;
+
+			/// Waits for the next simulated frame, then completes the frame callback of every window
+			auto update() noexcept -> lw::Failable<void>;
+			/// There is no connection to flush
+			auto flush() noexcept -> lw::Failable<void>;
+			[[nodiscard]]
+			auto pollEvent() noexcept -> std::optional<lw::Event>;
+
+			/// There is no input device, the state is always empty
+			[[nodiscard]]
+			auto getInputState() const noexcept -> lw::InputState;
+			[[nodiscard]]
+			auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics;
+
+		private:
+			std::unique_ptr<internals::InstanceState> m_state;
+	};
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/export.hpp"
+#include "liteway/image.hpp"
+#include "liteway/memory.hpp"
+
+
+namespace lw::headless {
+	class Instance;
+
+	namespace internals {
+		struct InstanceState;
+
+		struct Buffer {
+			std::vector<std::uint32_t> pixels;
+			/// Set while the buffer holds the last presented frame
+			bool isFront;
+		};
+
+		struct WindowState {
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+			InstanceState& instance;
+			lw::WindowId id;
+			std::string name;
+			std::uint32_t width;
+			std::uint32_t height;
+			std::size_t maxBufferCount;
+			std::vector<std::unique_ptr<Buffer>> buffers;
+			Buffer* backBuffer {nullptr};
+			bool isFramePending {false};
+			lw::MemoryStatistics memoryStatistics {};
+		};
+	}
+
+	class LW_EXPORT Window final {
+		public:
+			Window(const Window&) = delete;
+			auto operator=(const Window&) = delete;
+
+			inline Window() noexcept = default;
+			inline Window(Window&&) noexcept = default;
+			auto operator=(Window&& other) noexcept -> Window&;
+			~Window();
+
+			struct CreateInfos {
+				// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+				Instance& instance;
+				std::string_view title;
+				std::uint32_t width;
+				std::uint32_t height;
+				/// Maximum amount of buffers in the swapchain, they are only allocated when needed
+				std::size_t bufferCount {2uz};
+			};
+
+			static auto create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window>;
+
+			[[nodiscard]]
+			auto getId() const noexcept -> lw::WindowId;
+			[[nodiscard]]
+			auto getWidth() const noexcept -> std::uint32_t;
+			[[nodiscard]]
+			auto getHeight() const noexcept -> std::uint32_t;
+
+			auto getBackBuffer() noexcept -> lw::Failable<lw::ImageView>;
+			auto fill(const lw::Color& color) noexcept -> lw::Failable<void>;
+			/// The back buffer becomes the front buffer, and the previous front buffer can be reused
+			auto present() noexcept -> lw::Failable<void>;
+			[[nodiscard]]
+			auto isFramePending() const noexcept -> bool;
+			/// Last presented frame, what a compositor would have shown
+			[[nodiscard]]
+			auto getFrontBuffer() const noexcept -> std::optional<lw::ImageView>;
+
+			auto trim() noexcept -> void;
+			[[nodiscard]]
+			auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics;
+
+			/// There is no pointer without a compositor, the shape is accepted and ignored
+			auto setCursorShape(lw::CursorShape shape) noexcept -> lw::Failable<void>;
+
+		private:
+			static auto s_acquireBuffer(internals::WindowState& state) noexcept -> lw::Failable<internals::Buffer*>;
+			static auto s_destroyBuffer(internals::WindowState& state, internals::Buffer& buffer) noexcept -> void;
+
+			/// Unregisters the window from its instance and destroys its buffers, leaving it empty
+			auto destroy() noexcept -> void;
+
+			std::unique_ptr<internals::WindowState> m_state;
+	};
+}
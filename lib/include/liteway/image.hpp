@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+
+namespace lw {
+	/// Non-owning view over ARGB8888 pixels, rows are `stride` pixels apart
+	struct ImageView {
+		std::span<std::uint32_t> pixels;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t stride;
+
+		[[nodiscard]]
+		constexpr auto row(std::uint32_t y) const noexcept -> std::span<std::uint32_t> {
+			return pixels.subspan(static_cast<std::size_t> (y) * stride, width);
+		}
+	};
+}
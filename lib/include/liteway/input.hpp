@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "liteway/event.hpp"
+
+
+namespace lw {
+	struct Modifiers {
+		bool shift;
+		bool capsLock;
+		bool control;
+		bool alt;
+		bool super;
+		bool numLock;
+	};
+
+	/// State of the input devices as of the last `Instance::update`
+	struct InputState {
+		/// Amount of Linux evdev key codes, `KEY_MAX + 1`
+		static constexpr std::size_t keyCount {0x300};
+		/// Evdev code of the first button, `BTN_MOUSE`
+		static constexpr std::uint32_t firstButton {0x110};
+
+		lw::WindowId pointerFocus;
+		lw::WindowId keyboardFocus;
+		/// Surface local position
+		double pointerX;
+		double pointerY;
+		/// Bit `button - firstButton` is set while the button is held
+		std::uint32_t buttons;
+		std::array<std::uint64_t, keyCount / 64> keys;
+		lw::Modifiers modifiers;
+
+		[[nodiscard]]
+		constexpr auto isButtonPressed(std::uint32_t button) const noexcept -> bool {
+			return button >= firstButton && button - firstButton < 32 && ((buttons >> (button - firstButton)) & 1) != 0;
+		}
+
+		[[nodiscard]]
+		constexpr auto isKeyPressed(std::uint32_t key) const noexcept -> bool {
+			return key < keyCount && ((keys[key / 64] >> (key % 64)) & 1) != 0;
+		}
+
+		constexpr auto setButton(std::uint32_t button, bool isPressed) noexcept -> void {
+			if (button < firstButton || button - firstButton >= 32)
+				return;
+			const std::uint32_t mask {1u << (button - firstButton)};
+			buttons = isPressed ? buttons | mask : buttons & ~mask;
+		}
+
+		constexpr auto setKey(std::uint32_t key, bool isPressed) noexcept -> void {
+			if (key >= keyCount)
+				return;
+			const std::uint64_t mask {1ull << (key % 64)};
+			keys[key / 64] = isPressed ? keys[key / 64] | mask : keys[key / 64] & ~mask;
+		}
+	};
+}
@@ -1,13 +1,55 @@
 #pragma once
 
-#include "liteway/export.hpp"
+#include <optional>
+
+#include "liteway/backend.hpp"
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/input.hpp"
+#include "liteway/memory.hpp"
 
 
 namespace lw {
-	class LW_EXPORT Instance {
+	/*
+	 * Backend agnostic front end. The backend is picked at compile time, every call is forwarded without any
+	 * indirection and is inlined
+	 */
+	template <lw::Backend B = lw::backends::Wayland>
+	class Instance final {
 		public:
-			Instance();
+			using Backend = B;
+			using CreateInfos = typename B::Instance::CreateInfos;
+
+			Instance(const Instance&) = delete;
+			auto operator=(const Instance&) = delete;
+
+			inline Instance() noexcept = default;
+			inline ~Instance() = default;
+			inline Instance(Instance&&) noexcept = default;
+			inline auto operator=(Instance&&) noexcept -> Instance& = default;
+
+			static auto create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance>;
+
+			inline auto update() noexcept -> lw::Failable<void> {return m_backend.update();}
+			inline auto flush() noexcept -> lw::Failable<void> {return m_backend.flush();}
+			[[nodiscard]]
+			inline auto pollEvent() noexcept -> std::optional<lw::Event> {return m_backend.pollEvent();}
+			[[nodiscard]]
+			inline auto getInputState() const noexcept -> lw::InputState {return m_backend.getInputState();}
+			[[nodiscard]]
+			inline auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+				return m_backend.getMemoryStatistics();
+			}
+
+			/// Gives access to what only this backend supports
+			[[nodiscard]]
+			inline auto getBackend() noexcept -> typename B::Instance& {return m_backend;}
+			[[nodiscard]]
+			inline auto getBackend() const noexcept -> const typename B::Instance& {return m_backend;}
 
 		private:
+			typename B::Instance m_backend;
 	};
 }
+
+#include "liteway/instance.inl"
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <utility>
+
+#include "liteway/instance.hpp"
+
+
+namespace lw {
+	template <lw::Backend B>
+	auto Instance<B>::create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance> {
+		lw::Failable backendWithError {B::Instance::create(std::move(createInfos))};
+		if (!backendWithError)
+			return lw::pushToErrorStack(backendWithError, "Can't create backend instance");
+		Instance instance {};
+		instance.m_backend = std::move(*backendWithError);
+		return instance;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace lw {
+	struct MemoryStatistics {
+		/// Bytes of shared memory mapped in the client
+		std::size_t mappedBytes;
+		/// Amount of buffers currently alive
+		std::size_t bufferCount;
+		/// Bytes of shared memory pools the compositor keeps mapped for the alive buffers
+		std::size_t poolBytes;
+	};
+
+	constexpr auto operator+=(MemoryStatistics& lhs, const MemoryStatistics& rhs) noexcept -> MemoryStatistics& {
+		lhs.mappedBytes += rhs.mappedBytes;
+		lhs.bufferCount += rhs.bufferCount;
+		lhs.poolBytes += rhs.poolBytes;
+		return lhs;
+	}
+
+	constexpr auto operator-=(MemoryStatistics& lhs, const MemoryStatistics& rhs) noexcept -> MemoryStatistics& {
+		lhs.mappedBytes -= rhs.mappedBytes;
+		lhs.bufferCount -= rhs.bufferCount;
+		lhs.poolBytes -= rhs.poolBytes;
+		return lhs;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+namespace lw {
+	/*
+	 * Single writer, many readers. Readers never block the writer and never make a syscall, they retry while a store
+	 * is in progress. The value is kept as relaxed atomic words so concurrent copies aren't data races
+	 */
+	template <typename T>
+	requires std::is_trivially_copyable_v<T>
+	class SeqLock final {
+		static constexpr std::size_t s_wordCount {(sizeof(T) + sizeof(std::uint64_t) - 1uz) / sizeof(std::uint64_t)};
+		using Words = std::array<std::uint64_t, s_wordCount>;
+
+		public:
+			SeqLock(const SeqLock&) = delete;
+			auto operator=(const SeqLock&) = delete;
+			SeqLock(SeqLock&&) = delete;
+			auto operator=(SeqLock&&) = delete;
+
+			inline SeqLock() noexcept : SeqLock(T{}) {}
+			inline explicit SeqLock(const T& value) noexcept {
+				const Words words {s_toWords(value)};
+				for (std::size_t i {0}; i < s_wordCount; ++i)
+					m_words[i].store(words[i], std::memory_order_relaxed);
+			}
+			inline ~SeqLock() = default;
+
+			/// Must only be called by one thread at a time
+			inline auto store(const T& value) noexcept -> void {
+				const Words words {s_toWords(value)};
+				const std::uint32_t sequence {m_sequence.load(std::memory_order_relaxed)};
+				m_sequence.store(sequence + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				for (std::size_t i {0}; i < s_wordCount; ++i)
+					m_words[i].store(words[i], std::memory_order_relaxed);
+				m_sequence.store(sequence + 2, std::memory_order_release);
+			}
+
+			[[nodiscard]]
+			inline auto load() const noexcept -> T {
+				Words words {};
+				for (;;) {
+					const std::uint32_t sequence {m_sequence.load(std::memory_order_acquire)};
+					// odd while a store is in progress
+					if ((sequence & 1) != 0)
+						continue;
+					for (std::size_t i {0}; i < s_wordCount; ++i)
+						words[i] = m_words[i].load(std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (m_sequence.load(std::memory_order_relaxed) == sequence)
+						break;
+				}
+				// trivially copyable types may still lack a trivial default constructor, like `std::string_view`
+				T value {};
+				std::memcpy(static_cast<void*> (&value), words.data(), sizeof(T));
+				return value;
+			}
+
+		private:
+			static inline auto s_toWords(const T& value) noexcept -> Words {
+				Words words {};
+				std::memcpy(words.data(), &value, sizeof(T));
+				return words;
+			}
+
+			std::atomic<std::uint32_t> m_sequence {0};
+			std::array<std::atomic<std::uint64_t>, s_wordCount> m_words;
+	};
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "liteway/color.hpp"
+#include "liteway/error.hpp"
+#include "liteway/export.hpp"
+#include "liteway/image.hpp"
+
+
+namespace lw {
+	/// Chosen by the application, liteway only uses it to tell glyphs of different fonts apart
+	enum class FontId : std::uint32_t {};
+
+	/// Coverage mask of a glyph, one byte per pixel
+	struct GlyphBitmap {
+		std::span<const std::uint8_t> coverage;
+		std::uint32_t width;
+		std::uint32_t height;
+		/// Bytes between two rows
+		std::uint32_t stride;
+		/// Offset from the pen position to the left of the bitmap
+		std::int32_t bearingX;
+		/// Offset from the baseline up to the top of the bitmap
+		std::int32_t bearingY;
+		/// Pixels the pen moves after the glyph
+		float advance;
+	};
+
+	/*
+	 * Only called the first time a glyph is needed, usually wrapping FreeType or stb_truetype. The coverage only has
+	 * to stay valid until it returns
+	 */
+	using GlyphRasterizer = std::move_only_function<
+		auto(lw::FontId font, std::uint32_t size, char32_t codepoint) noexcept -> lw::Failable<lw::GlyphBitmap>
+	>;
+
+	struct GlyphCacheStatistics {
+		std::size_t glyphCount;
+		std::size_t hitCount;
+		std::size_t missCount;
+		/// Times the atlas was full and had to be emptied
+		std::size_t flushCount;
+	};
+
+	struct TextInfos {
+		lw::FontId font;
+		std::uint32_t size;
+		/// UTF-8, invalid sequences are drawn as U+FFFD
+		std::string_view text;
+		std::int32_t x;
+		/// Position of the baseline
+		std::int32_t y;
+		lw::Color color;
+	};
+
+
+	/*
+	 * Rasterizes each glyph once into a single channel atlas packed in shelves, so drawing text is only blending rows
+	 * of the atlas into the target
+	 */
+	class LW_EXPORT GlyphCache final {
+		public:
+			GlyphCache(const GlyphCache&) = delete;
+			auto operator=(const GlyphCache&) = delete;
+
+			inline GlyphCache() noexcept = default;
+			inline ~GlyphCache() = default;
+			inline GlyphCache(GlyphCache&&) noexcept = default;
+			inline auto operator=(GlyphCache&&) noexcept -> GlyphCache& = default;
+
+			struct CreateInfos {
+				lw::GlyphRasterizer rasterizer;
+				std::uint32_t atlasWidth {1024};
+				std::uint32_t atlasHeight {1024};
+			};
+
+			static auto create(CreateInfos&& createInfos) noexcept -> lw::Failable<GlyphCache>;
+
+			/// Returns the pen position after the text
+			auto drawText(const lw::ImageView& target, const TextInfos& textInfos) noexcept -> lw::Failable<float>;
+			/// Width of the text in pixels, rasterizing the glyphs that aren't cached yet
+			auto measureText(lw::FontId font, std::uint32_t size, std::string_view text) noexcept
+				-> lw::Failable<float>;
+
+			auto clear() noexcept -> void;
+			[[nodiscard]]
+			auto getStatistics() const noexcept -> GlyphCacheStatistics;
+
+		private:
+			struct GlyphKey {
+				lw::FontId font;
+				std::uint32_t size;
+				char32_t codepoint;
+
+				auto operator==(const GlyphKey&) const noexcept -> bool = default;
+			};
+
+			struct GlyphKeyHash {
+				auto operator()(const GlyphKey& key) const noexcept -> std::size_t;
+			};
+
+			struct Glyph {
+				std::uint32_t atlasX;
+				std::uint32_t atlasY;
+				std::uint32_t width;
+				std::uint32_t height;
+				std::int32_t bearingX;
+				std::int32_t bearingY;
+				float advance;
+			};
+
+			/// A row of the atlas as high as the first glyph put into it, glyphs are added left to right
+			struct Shelf {
+				std::uint32_t y;
+				std::uint32_t height;
+				std::uint32_t width;
+			};
+
+			struct AtlasPosition {
+				std::uint32_t x;
+				std::uint32_t y;
+			};
+
+			auto getGlyph(const GlyphKey& key) noexcept -> lw::Failable<const Glyph*>;
+			auto allocate(std::uint32_t width, std::uint32_t height) noexcept -> std::optional<AtlasPosition>;
+
+			lw::GlyphRasterizer m_rasterizer;
+			std::uint32_t m_atlasWidth {0};
+			std::uint32_t m_atlasHeight {0};
+			std::vector<std::uint8_t> m_atlas;
+			std::vector<Shelf> m_shelves;
+			std::unordered_map<GlyphKey, Glyph, GlyphKeyHash> m_glyphs;
+			GlyphCacheStatistics m_statistics {};
+	};
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+#include "liteway/error.hpp"
+#include "liteway/export.hpp"
+
+#ifndef LW_TRACING_ENABLED
+	#define LW_TRACING_ENABLED 0
+#endif
+
+
+namespace lw::trace {
+	/// Set by the `LITEWAY_TRACING` CMake option. When disabled every tracing call compiles to nothing
+	constexpr bool isEnabled {LW_TRACING_ENABLED != 0};
+
+	enum class EventType : std::uint8_t {
+		scope,
+		counter,
+		instant
+	};
+
+	/// Names must outlive the trace, in practice they are string literals
+	struct Event {
+		std::string_view name;
+		std::uint64_t timestamp;
+		/// Duration in nanoseconds for scopes, value for counters, unused for instants
+		std::int64_t value;
+		EventType type;
+	};
+
+	LW_EXPORT auto now() noexcept -> std::uint64_t;
+	/// Lock-free, goes into a ring owned by the calling thread. The oldest events are overwritten when it is full
+	LW_EXPORT auto record(const Event& event) noexcept -> void;
+	/// Writes every recorded event of every thread as Chrome trace-event JSON, loadable in Perfetto
+	LW_EXPORT auto exportChromeJson(std::FILE* file) noexcept -> lw::Failable<void>;
+
+
+	class Scope final {
+		public:
+			Scope(const Scope&) = delete;
+			auto operator=(const Scope&) = delete;
+			Scope(Scope&&) = delete;
+			auto operator=(Scope&&) = delete;
+
+			inline explicit Scope(std::string_view name) noexcept {
+				if constexpr (isEnabled) {
+					m_name = name;
+					m_start = lw::trace::now();
+				}
+			}
+			inline ~Scope() {
+				if constexpr (isEnabled) {
+					const std::uint64_t end {lw::trace::now()};
+					lw::trace::record({
+						.name = m_name,
+						.timestamp = m_start,
+						.value = static_cast<std::int64_t> (end - m_start),
+						.type = EventType::scope
+					});
+				}
+			}
+
+		private:
+			std::string_view m_name {};
+			std::uint64_t m_start {};
+	};
+
+
+	inline auto counter(std::string_view name, std::int64_t value) noexcept -> void {
+		if constexpr (isEnabled) {
+			lw::trace::record({
+				.name = name,
+				.timestamp = lw::trace::now(),
+				.value = value,
+				.type = EventType::counter
+			});
+		}
+	}
+
+	inline auto instant(std::string_view name) noexcept -> void {
+		if constexpr (isEnabled) {
+			lw::trace::record({
+				.name = name,
+				.timestamp = lw::trace::now(),
+				.value = 0,
+				.type = EventType::instant
+			});
+		}
+	}
+}
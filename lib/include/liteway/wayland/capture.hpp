@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+#include "liteway/error.hpp"
+
+
+namespace lw::wayland::internals {
+	/// Rings mapped from an io_uring instance, see `io_uring_setup(2)`
+	struct IoUring {
+		int fd {-1};
+		std::span<std::byte> submissionRing {};
+		std::span<std::byte> completionRing {};
+		std::span<io_uring_sqe> submissionEntries {};
+		std::uint32_t* submissionTail {nullptr};
+		std::uint32_t* submissionArray {nullptr};
+		std::uint32_t submissionMask {0};
+		std::uint32_t* completionHead {nullptr};
+		std::uint32_t* completionTail {nullptr};
+		std::uint32_t completionMask {0};
+		std::uint32_t completionEntryCount {0};
+		io_uring_cqe* completions {nullptr};
+	};
+
+	/*
+	 * Appends frames to a file straight from the memory they are in. Writes go through io_uring when the kernel
+	 * supports it, otherwise through a writer thread. The memory of a write must stay untouched until its token comes
+	 * back from `collectCompleted`
+	 */
+	class FrameWriter final {
+		public:
+			FrameWriter(const FrameWriter&) = delete;
+			auto operator=(const FrameWriter&) = delete;
+			FrameWriter(FrameWriter&&) = delete;
+			auto operator=(FrameWriter&&) = delete;
+
+			inline FrameWriter() noexcept = default;
+			inline ~FrameWriter() {static_cast<void> (this->close());}
+
+			auto open(std::string_view path) noexcept -> lw::Failable<void>;
+			/*
+			 * Waits for every pending write, dropping their tokens, then closes the file. If waiting keeps failing the
+			 * pending writes are cancelled and an error is returned, their memory may be reused right after
+			 */
+			auto close() noexcept -> lw::Failable<void>;
+			[[nodiscard]]
+			inline auto isOpen() const noexcept -> bool {return m_file >= 0;}
+			[[nodiscard]]
+			inline auto getPendingWriteCount() const noexcept -> std::size_t {return m_pendingWriteCount;}
+
+			auto write(std::span<const std::byte> data, void* token) noexcept -> lw::Failable<void>;
+			/// Appends the tokens of the writes that completed since the last call, never blocks
+			auto collectCompleted(std::vector<void*>& tokens) noexcept -> lw::Failable<void>;
+			/// Blocks until at least one pending write completes
+			auto waitForCompletion() noexcept -> lw::Failable<void>;
+
+		private:
+			struct Request {
+				std::span<const std::byte> data;
+				std::uint64_t offset;
+				void* token;
+			};
+
+			auto setupIoUring() noexcept -> lw::Failable<void>;
+			auto destroyIoUring() noexcept -> void;
+			auto submitToIoUring(Request& request) noexcept -> lw::Failable<void>;
+			/// Best effort cancellation of every request submitted to io_uring
+			auto cancelIoUring() noexcept -> void;
+			auto reapIoUring() noexcept -> lw::Failable<void>;
+			auto runWriterThread(std::stop_token stopToken) noexcept -> void;
+
+			int m_file {-1};
+			std::uint64_t m_offset {0};
+			std::size_t m_pendingWriteCount {0};
+			internals::IoUring m_ring {};
+			/// Requests submitted to io_uring, heap allocated as their address is the completion's user data
+			std::vector<std::unique_ptr<Request>> m_ringRequests {};
+
+			std::mutex m_mutex {};
+			std::condition_variable_any m_condition {};
+			std::deque<Request> m_threadRequests {};
+			std::vector<void*> m_completed {};
+			/// `errno` of the first write that failed
+			int m_writeError {0};
+			std::jthread m_thread {};
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <wayland-client.h>
+
+#include "liteway/event.hpp"
+#include "liteway/pointer.hpp"
+
+
+namespace lw::wayland {
+	/*
+	 * One representation of offered data. The fd must be seekable, like a regular file or a memfd, so it can be sent
+	 * with `sendfile` without ever being read into memory. Liteway keeps its own duplicate of it
+	 */
+	struct DataContent {
+		std::string_view mimeType;
+		int fd;
+	};
+
+
+	namespace internals {
+		struct InstanceState;
+
+		/// Heap allocated as it is the user data of its `wl_data_offer`'s listener
+		struct DataOffer {
+			DataOffer(const DataOffer&) = delete;
+			auto operator=(const DataOffer&) = delete;
+			DataOffer(DataOffer&&) = delete;
+			auto operator=(DataOffer&&) = delete;
+
+			inline explicit DataOffer(wl_data_offer* dataOffer) noexcept : offer {dataOffer} {}
+			inline ~DataOffer() {
+				if (offer != nullptr)
+					wl_data_offer_destroy(offer.release());
+			}
+
+			lw::Owned<wl_data_offer*> offer;
+			std::vector<std::string> mimeTypes {};
+		};
+
+		struct DataSourceContent {
+			std::string mimeType;
+			int fd;
+		};
+
+		/// Heap allocated as it is the user data of its `wl_data_source`'s listener
+		struct DataSource {
+			DataSource(const DataSource&) = delete;
+			auto operator=(const DataSource&) = delete;
+			DataSource(DataSource&&) = delete;
+			auto operator=(DataSource&&) = delete;
+
+			inline explicit DataSource(InstanceState& instanceState) noexcept : instance {instanceState} {}
+			~DataSource();
+
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+			InstanceState& instance;
+			lw::Owned<wl_data_source*> source {};
+			std::vector<DataSourceContent> contents {};
+		};
+
+		enum class TransferDirection : std::uint8_t {
+			receive,
+			send
+		};
+
+		/// Driven by `Instance::update`, which polls its pipe next to the display's fd
+		struct Transfer {
+			lw::TransferId id;
+			TransferDirection direction;
+			/// Our non-blocking end of the pipe shared with the other client
+			int pipe;
+			/// Duplicate of the application's fd, written to when receiving and read from when sending
+			int file;
+			/// Bytes moved so far, which is also the read offset of `file` when sending
+			std::uint64_t size;
+			/// Dropped data offers are finished once their transfer is over
+			std::unique_ptr<DataOffer> dropOffer;
+		};
+	}
+}
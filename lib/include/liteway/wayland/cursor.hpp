@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <wayland-client.h>
+#include <wayland-cursor.h>
+
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/pointer.hpp"
+
+
+namespace lw::wayland::internals {
+	struct InstanceState;
+
+	/*
+	 * Fallback used when the compositor doesn't support `wp_cursor_shape_v1`. The theme is only loaded the first
+	 * time a cursor is needed and is shared by every window of the instance. `wl_cursor_image_get_buffer` keeps the
+	 * buffers it creates, so each image is uploaded to shared memory at most once
+	 */
+	class CursorThemeCache final {
+		public:
+			CursorThemeCache(const CursorThemeCache&) = delete;
+			auto operator=(const CursorThemeCache&) = delete;
+			CursorThemeCache(CursorThemeCache&&) = delete;
+			auto operator=(CursorThemeCache&&) = delete;
+
+			inline CursorThemeCache() noexcept = default;
+			inline ~CursorThemeCache() {this->destroy();}
+
+			/// Must be called before the display is disconnected
+			auto destroy() noexcept -> void;
+
+			auto setCursor(
+				InstanceState& state,
+				std::uint32_t serial,
+				lw::CursorShape shape
+			) noexcept -> lw::Failable<void>;
+
+		private:
+			auto load(InstanceState& state) noexcept -> lw::Failable<void>;
+			auto getCursor(lw::CursorShape shape) noexcept -> wl_cursor*;
+
+			lw::Owned<wl_cursor_theme*> m_theme;
+			lw::Owned<wl_surface*> m_surface;
+			wl_cursor_image* m_attachedImage {nullptr};
+			std::array<wl_cursor*, lw::cursorShapeCount> m_cursors {};
+			std::array<bool, lw::cursorShapeCount> m_lookedUp {};
+	};
+
+
+	auto setCursorShape(InstanceState& state, std::uint32_t serial, lw::CursorShape shape) noexcept
+		-> lw::Failable<void>;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <wayland-egl.h>
+
+#include "liteway/error.hpp"
+#include "liteway/wayland/window.hpp"
+
+
+/*
+ * Header only so liteway itself never links against `wayland-egl`. The window must have been created with
+ * `Window::Presentation::native`
+ */
+namespace lw::wayland {
+	/// The returned window is owned by the caller and must be destroyed with `wl_egl_window_destroy`
+	inline auto createEglWindow(const Window& window) noexcept -> lw::Failable<wl_egl_window*> {
+		wl_egl_window* eglWindow {wl_egl_window_create(
+			window.getNativeHandles().surface,
+			static_cast<int> (window.getWidth()),
+			static_cast<int> (window.getHeight())
+		)};
+		if (eglWindow == nullptr)
+			return lw::makeErrorStack("Can't create wayland egl window");
+		return eglWindow;
+	}
+}
@@ -1,17 +1,49 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+
+#include <cursor-shape-v1/cursor-shape-v1-client-protocol.h>
+#include <relative-pointer-unstable-v1/relative-pointer-unstable-v1-client-protocol.h>
 #include <xdg-shell/xdg-shell-client-protocol.h>
 #include <wayland-client.h>
 
 #include "liteway/error.hpp"
+#include "liteway/event.hpp"
 #include "liteway/export.hpp"
+#include "liteway/input.hpp"
+#include "liteway/memory.hpp"
 #include "liteway/pointer.hpp"
+#include "liteway/seqlock.hpp"
+#include "liteway/wayland/clipboard.hpp"
+#include "liteway/wayland/cursor.hpp"
 
 
 namespace lw::wayland {
+	/*
+	 * Counted around the calls liteway makes into libwayland, so the sends libwayland makes on its own when its
+	 * request buffer fills up are missed, as are the roundtrips of `Instance::create`
+	 */
+	struct ConnectionStatistics {
+		std::uint32_t sendCount;
+		std::size_t sentBytes;
+		std::uint32_t receiveCount;
+		/// libwayland doesn't tell how many bytes it read, only how many events it dispatched
+		std::uint32_t eventCount;
+	};
+
 	namespace internals {
 		struct InstanceState;
+		struct WindowState;
 
 		using SeatListenerUserData = std::pair<InstanceState&, lw::Failable<void>&>;
 		struct SharedMemoryListenerUserData {
@@ -32,6 +64,27 @@ namespace lw::wayland {
 			SharedMemoryListenerUserData sharedMemoryListenerUserData;
 		};
 
+		/*
+		 * Key repeat is done client side with a `timerfd` polled next to the display's fd. It is disarmed while no key
+		 * is held, so it costs nothing then
+		 */
+		struct KeyRepeat {
+			int timer {-1};
+			/// Repeats per second, 0 disables key repeat
+			std::int32_t rate {0};
+			std::uint64_t delay {0};
+			std::optional<std::uint32_t> key {};
+			std::uint64_t nextTimestamp {0};
+		};
+
+		/// Motion accumulated during the current `wl_pointer.frame`
+		struct PointerMotion {
+			std::optional<lw::PointerMotionEvent> pending {};
+			double lastX {0.0};
+			double lastY {0.0};
+			bool keepHistory {false};
+		};
+
 		struct InstanceState {
 			inline InstanceState() noexcept :
 				registryListenerUserData {*this}
@@ -46,10 +99,55 @@ namespace lw::wayland {
 			lw::Owned<wl_seat*> seat;
 			lw::Owned<wl_pointer*> pointer;
 			lw::Owned<wl_keyboard*> keyboard;
+			lw::Owned<wp_cursor_shape_manager_v1*> cursorShapeManager;
+			lw::Owned<wp_cursor_shape_device_v1*> cursorShapeDevice;
+			lw::Owned<zwp_relative_pointer_manager_v1*> relativePointerManager;
+			lw::Owned<zwp_relative_pointer_v1*> relativePointer;
+			internals::CursorThemeCache cursorThemeCache;
+			wl_surface* pointerFocus {nullptr};
+			std::uint32_t pointerEnterSerial {0};
+			internals::PointerMotion pointerMotion {};
+			wl_surface* keyboardFocus {nullptr};
+			internals::KeyRepeat keyRepeat {};
+			/// Updated by the listeners, and published once per `update` if it changed
+			lw::InputState input {};
+			bool isInputDirty {false};
+			lw::SeqLock<lw::InputState> publishedInput {};
+			/// Serial of the last input event, which the compositor requires to set the clipboard
+			std::uint32_t inputSerial {0};
+			/// Serial of the last button press, which the compositor requires to start a drag
+			std::uint32_t pointerButtonSerial {0};
+			lw::Owned<wl_data_device_manager*> dataDeviceManager;
+			lw::Owned<wl_data_device*> dataDevice;
+			/// Introduced by `wl_data_device.data_offer`, until a selection or drag enter event tells what it is for
+			std::unique_ptr<internals::DataOffer> pendingDataOffer;
+			std::unique_ptr<internals::DataOffer> clipboardOffer;
+			std::unique_ptr<internals::DataOffer> dragOffer;
+			/// Kept until its data is received or another drop replaces it
+			std::unique_ptr<internals::DataOffer> droppedOffer;
+			wl_surface* dragFocus {nullptr};
+			std::uint32_t dragEnterSerial {0};
+			double dragX {0.0};
+			double dragY {0.0};
+			std::unique_ptr<internals::DataSource> clipboardSource;
+			std::unique_ptr<internals::DataSource> dragSource;
+			std::vector<internals::Transfer> transfers;
+			std::uint32_t nextTransferId {1};
+			std::vector<pollfd> pollFds;
+			/// Set when the socket was full, the rest of the requests is sent once it is writable again
+			bool isFlushPending {false};
+			ConnectionStatistics connectionStatistics {};
+			ConnectionStatistics frameConnectionStatistics {};
+			std::deque<lw::Event> events;
+			std::vector<WindowState*> windows;
+			lw::MemoryStatistics memoryStatistics {};
+			std::size_t memoryBudget {std::numeric_limits<std::size_t>::max()};
 		};
 	}
 
 
+	class Window;
+
 	class LW_EXPORT Instance {
 		friend class Window;
 		public:
@@ -62,12 +160,49 @@ namespace lw::wayland {
 			~Instance();
 
 			struct CreateInfos {
-
+				/// Bytes of shared memory all windows together may map before their idle buffers get trimmed
+				std::size_t memoryBudget {std::numeric_limits<std::size_t>::max()};
+				/// Queue every pointer motion instead of merging them, for applications drawing the pointer's path
+				bool keepPointerMotionHistory {false};
 			};
 
 			static auto create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance>;
 
+			/*
+			 * Flushes the requests queued since the last call, so the presents of every window go out together, then
+			 * waits for the compositor or the key repeat timer and dispatches everything that is ready
+			 */
 			auto update() noexcept -> lw::Failable<void>;
+			/// Sends the queued requests now without blocking. If the socket is full, `update` sends the rest later
+			auto flush() noexcept -> lw::Failable<void>;
+			[[nodiscard]]
+			auto pollEvent() noexcept -> std::optional<lw::Event>;
+
+			/// Safe to call from any thread, without locking nor blocking
+			[[nodiscard]]
+			auto getInputState() const noexcept -> lw::InputState;
+
+			/// Statistics of the last frame, from the flush of an `update` to the flush of the next one
+			[[nodiscard]]
+			auto getConnectionStatistics() const noexcept -> ConnectionStatistics;
+
+			[[nodiscard]]
+			auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics;
+			auto setMemoryBudget(std::size_t memoryBudget) noexcept -> void;
+
+			/// Offers the contents as the clipboard, an empty span clears it
+			auto setClipboard(std::span<const DataContent> contents) noexcept -> lw::Failable<void>;
+			/// Must be called right after a button press on the window, while the pointer is still held
+			auto startDrag(const Window& window, std::span<const DataContent> contents) noexcept -> lw::Failable<void>;
+			/*
+			 * Streams the clipboard content of the given MIME type into the fd, which liteway duplicates. The transfer
+			 * is driven by `update` and ends with a `lw::TransferEvent`
+			 */
+			auto receiveClipboard(std::string_view mimeType, int fd) noexcept -> lw::Failable<lw::TransferId>;
+			/// Tells the dragging client whether the hovered window would take its data, `nullopt` refuses it
+			auto acceptDrag(std::optional<std::string_view> mimeType) noexcept -> lw::Failable<void>;
+			/// Like `receiveClipboard`, for the data of the last drop
+			auto receiveDrop(std::string_view mimeType, int fd) noexcept -> lw::Failable<lw::TransferId>;
 
 			template <typename T>
 			static auto bindGlobalFromRegistry(
@@ -89,8 +224,153 @@ namespace lw::wayland {
 				std::uint32_t format
 			) noexcept -> void;
 			static auto handleSeatCapabilites(void* data, wl_seat* seat, std::uint32_t capabilities) noexcept -> void;
+			static auto handlePointerEnter(
+				void* data,
+				wl_pointer* pointer,
+				std::uint32_t serial,
+				wl_surface* surface,
+				wl_fixed_t x,
+				wl_fixed_t y
+			) noexcept -> void;
+			static auto handlePointerLeave(
+				void* data,
+				wl_pointer* pointer,
+				std::uint32_t serial,
+				wl_surface* surface
+			) noexcept -> void;
+			static auto handlePointerMotion(
+				void* data,
+				wl_pointer* pointer,
+				std::uint32_t time,
+				wl_fixed_t x,
+				wl_fixed_t y
+			) noexcept -> void;
+			static auto handlePointerButton(
+				void* data,
+				wl_pointer* pointer,
+				std::uint32_t serial,
+				std::uint32_t time,
+				std::uint32_t button,
+				std::uint32_t buttonState
+			) noexcept -> void;
+			static auto handlePointerFrame(void* data, wl_pointer* pointer) noexcept -> void;
+			static auto handleRelativePointerMotion(
+				void* data,
+				zwp_relative_pointer_v1* relativePointer,
+				std::uint32_t timeHigh,
+				std::uint32_t timeLow,
+				wl_fixed_t deltaX,
+				wl_fixed_t deltaY,
+				wl_fixed_t unacceleratedDeltaX,
+				wl_fixed_t unacceleratedDeltaY
+			) noexcept -> void;
+			static auto handleKeyboardEnter(
+				void* data,
+				wl_keyboard* keyboard,
+				std::uint32_t serial,
+				wl_surface* surface,
+				wl_array* keys
+			) noexcept -> void;
+			static auto handleKeyboardLeave(
+				void* data,
+				wl_keyboard* keyboard,
+				std::uint32_t serial,
+				wl_surface* surface
+			) noexcept -> void;
+			static auto handleKeyboardKey(
+				void* data,
+				wl_keyboard* keyboard,
+				std::uint32_t serial,
+				std::uint32_t time,
+				std::uint32_t key,
+				std::uint32_t keyState
+			) noexcept -> void;
+			static auto handleKeyboardModifiers(
+				void* data,
+				wl_keyboard* keyboard,
+				std::uint32_t serial,
+				std::uint32_t depressed,
+				std::uint32_t latched,
+				std::uint32_t locked,
+				std::uint32_t group
+			) noexcept -> void;
+			static auto handleKeyboardRepeatInfo(
+				void* data,
+				wl_keyboard* keyboard,
+				std::int32_t rate,
+				std::int32_t delay
+			) noexcept -> void;
+			static auto handleDataDeviceDataOffer(
+				void* data,
+				wl_data_device* dataDevice,
+				wl_data_offer* dataOffer
+			) noexcept -> void;
+			static auto handleDataDeviceEnter(
+				void* data,
+				wl_data_device* dataDevice,
+				std::uint32_t serial,
+				wl_surface* surface,
+				wl_fixed_t x,
+				wl_fixed_t y,
+				wl_data_offer* dataOffer
+			) noexcept -> void;
+			static auto handleDataDeviceLeave(void* data, wl_data_device* dataDevice) noexcept -> void;
+			static auto handleDataDeviceMotion(
+				void* data,
+				wl_data_device* dataDevice,
+				std::uint32_t time,
+				wl_fixed_t x,
+				wl_fixed_t y
+			) noexcept -> void;
+			static auto handleDataDeviceDrop(void* data, wl_data_device* dataDevice) noexcept -> void;
+			static auto handleDataDeviceSelection(
+				void* data,
+				wl_data_device* dataDevice,
+				wl_data_offer* dataOffer
+			) noexcept -> void;
+			static auto handleDataOfferOffer(void* data, wl_data_offer* dataOffer, const char* mimeType) noexcept
+				-> void;
+			static auto handleDataSourceSend(
+				void* data,
+				wl_data_source* dataSource,
+				const char* mimeType,
+				std::int32_t fd
+			) noexcept -> void;
+			static auto handleDataSourceCancelled(void* data, wl_data_source* dataSource) noexcept -> void;
 
 		private:
+			static auto s_getPendingPointerMotion(internals::InstanceState& state) noexcept -> lw::PointerMotionEvent&;
+			static auto s_flushPointerMotion(internals::InstanceState& state) noexcept -> void;
+			static auto s_startKeyRepeat(
+				internals::InstanceState& state,
+				std::uint32_t key,
+				std::uint64_t pressTimestamp
+			) noexcept -> void;
+			static auto s_stopKeyRepeat(internals::InstanceState& state) noexcept -> void;
+			static auto s_dispatchKeyRepeats(internals::InstanceState& state) noexcept -> lw::Failable<void>;
+			static auto s_flush(internals::InstanceState& state) noexcept -> lw::Failable<void>;
+			static auto s_publishInputState(internals::InstanceState& state) noexcept -> void;
+			static auto s_createDataDevice(internals::InstanceState& state) noexcept -> lw::Failable<void>;
+			static auto s_destroyDataDevice(internals::InstanceState& state) noexcept -> void;
+			static auto s_takeDataOffer(internals::InstanceState& state, wl_data_offer* dataOffer) noexcept
+				-> std::unique_ptr<internals::DataOffer>;
+			static auto s_createDataSource(
+				internals::InstanceState& state,
+				std::span<const DataContent> contents
+			) noexcept -> lw::Failable<std::unique_ptr<internals::DataSource>>;
+			static auto s_startReceive(
+				internals::InstanceState& state,
+				wl_data_offer* dataOffer,
+				std::string_view mimeType,
+				int fd
+			) noexcept -> lw::Failable<internals::Transfer*>;
+			static auto s_startSend(internals::InstanceState& state, int file, int pipe) noexcept
+				-> lw::Failable<void>;
+			/// `pollFds` holds one entry per transfer, in the same order
+			static auto s_dispatchTransfers(internals::InstanceState& state, std::span<const pollfd> pollFds) noexcept
+				-> void;
+			static auto s_closeTransfer(internals::Transfer& transfer) noexcept -> void;
+
 			std::unique_ptr<internals::InstanceState> m_state;
 	};
 }
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef VK_USE_PLATFORM_WAYLAND_KHR
+	#define VK_USE_PLATFORM_WAYLAND_KHR
+#endif
+#include <vulkan/vulkan.h>
+
+#include "liteway/error.hpp"
+#include "liteway/wayland/window.hpp"
+
+
+/*
+ * Header only so liteway itself never links against the Vulkan loader. The instance must have been created with
+ * `VK_KHR_surface` and `VK_KHR_wayland_surface`, and the window with `Window::Presentation::native`
+ */
+namespace lw::wayland {
+	inline auto createVulkanSurface(
+		const Window& window,
+		VkInstance instance,
+		const VkAllocationCallbacks* allocator = nullptr
+	) noexcept -> lw::Failable<VkSurfaceKHR> {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		const auto createWaylandSurface {reinterpret_cast<PFN_vkCreateWaylandSurfaceKHR> (
+			vkGetInstanceProcAddr(instance, "vkCreateWaylandSurfaceKHR")
+		)};
+		if (createWaylandSurface == nullptr)
+			return lw::makeErrorStack("Can't load 'vkCreateWaylandSurfaceKHR', is 'VK_KHR_wayland_surface' enabled ?");
+
+		const NativeHandles handles {window.getNativeHandles()};
+		const VkWaylandSurfaceCreateInfoKHR createInfos {
+			.sType = VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR,
+			.pNext = nullptr,
+			.flags = 0,
+			.display = handles.display,
+			.surface = handles.surface
+		};
+		VkSurfaceKHR surface {VK_NULL_HANDLE};
+		const VkResult result {createWaylandSurface(instance, &createInfos, allocator, &surface)};
+		if (result != VK_SUCCESS)
+			return lw::makeErrorStack("Can't create vulkan wayland surface : VkResult {}", static_cast<int> (result));
+		return surface;
+	}
+}
@@ -1,28 +1,122 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <xdg-shell/xdg-shell-client-protocol.h>
 #include <wayland-client.h>
 
 #include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
 #include "liteway/error.hpp"
+#include "liteway/event.hpp"
 #include "liteway/export.hpp"
+#include "liteway/image.hpp"
+#include "liteway/memory.hpp"
 #include "liteway/pointer.hpp"
 
 
 namespace lw::wayland {
 	class Instance;
 
+	namespace internals {
+		struct InstanceState;
+		struct WindowState;
+		class FrameWriter;
+
+		/// Keeps `FrameWriter` and the io_uring and thread headers it needs out of this header
+		struct FrameWriterDeleter {
+			auto operator()(FrameWriter* frameWriter) const noexcept -> void;
+		};
+
+		struct Buffer {
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+			WindowState& window;
+			lw::Owned<wl_buffer*> buffer;
+			lw::OwnedSpan<std::byte> data;
+			std::size_t poolSize;
+			/// Set while the compositor may read from the buffer, between its attach and its release
+			bool isBusy;
+			/// Set while the buffer is being written to the capture file
+			bool isBeingCaptured {false};
+		};
+
+		/// Area given to `wl_surface_damage_buffer`, in buffer pixels
+		struct DamageRegion {
+			std::int32_t x;
+			std::int32_t y;
+			std::int32_t width;
+			std::int32_t height;
+		};
+
+		/*
+		 * Heap allocated so its address stays valid when the `Window` is moved. It is stored as the user data of the
+		 * window's `wl_surface`, which lets the instance's listeners find the window a surface belongs to
+		 */
+		struct WindowState {
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+			InstanceState& instance;
+			lw::CursorShape cursorShape;
+			std::string name;
+			std::uint32_t width;
+			std::uint32_t height;
+			bool usesSharedMemory;
+			std::size_t maxBufferCount;
+			/// Each buffer is heap allocated as it is the user data of its `wl_buffer`'s release listener
+			std::vector<std::unique_ptr<Buffer>> buffers;
+			Buffer* backBuffer {nullptr};
+			lw::Owned<wl_callback*> frameCallback;
+			lw::MemoryStatistics memoryStatistics {};
+			/// Only allocated while capturing, the writer thread of the fallback keeps a pointer to it
+			std::unique_ptr<internals::FrameWriter, internals::FrameWriterDeleter> frameWriter {};
+			std::uint32_t captureInterval {1};
+			std::uint64_t presentCount {0};
+			bool isConfigured {false};
+			bool isSuspended {false};
+			/// 0 disables damage detection, every present then damages the whole buffer
+			std::uint32_t damageTileSize {0};
+			/// Tile hashes of the last presented frame, row by row, empty until the first present
+			std::vector<std::uint64_t> tileHashes {};
+			/// Tile hashes of the frame being presented, swapped into `tileHashes` once it is committed
+			std::vector<std::uint64_t> pendingTileHashes {};
+			std::vector<DamageRegion> damageRegions {};
+			std::size_t damagedTileCount {0};
+		};
+
+		inline auto getWindowId(wl_surface* surface) noexcept -> lw::WindowId {
+			if (surface == nullptr)
+				return lw::WindowId{};
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			return static_cast<lw::WindowId> (wl_proxy_get_id(reinterpret_cast<wl_proxy*> (surface)));
+		}
+	}
+
+	/// Everything a graphics API needs to present to a window on its own
+	struct NativeHandles {
+		wl_display* display;
+		wl_surface* surface;
+	};
+
 	class LW_EXPORT Window final {
+		friend class Instance;
 		public:
 			Window(const Window&) = delete;
 			auto operator=(const Window&) = delete;
 
+			enum class Presentation : std::uint8_t {
+				/// Liteway allocates a swapchain of shared memory buffers that is filled by the CPU
+				sharedMemory,
+				/// No buffer is ever allocated, the surface is presented to by Vulkan or EGL through its native handles
+				native
+			};
+
 			inline Window() noexcept = default;
 			inline Window(Window&&) noexcept = default;
-			inline auto operator=(Window&&) noexcept -> Window& = default;
+			auto operator=(Window&& other) noexcept -> Window&;
 			~Window();
 
 			struct CreateInfos {
@@ -31,11 +125,79 @@ namespace lw::wayland {
 				std::string_view title;
 				std::uint32_t width;
 				std::uint32_t height;
+				Presentation presentation {Presentation::sharedMemory};
+				/// Maximum amount of buffers in the swapchain, they are only allocated when needed
+				std::size_t bufferCount {2uz};
+				/*
+				 * When not 0, `present` hashes the back buffer in tiles of this size and only damages the ones that
+				 * changed since the last presented frame, for clients redrawing everything every frame
+				 */
+				std::uint32_t damageTileSize {0};
+			};
+
+			/*
+			 * Frames are written without any header as raw little endian ARGB8888, that is BGRA bytes, of
+			 * `getWidth() * getHeight()` pixels, e.g. readable with
+			 * `ffmpeg -f rawvideo -pixel_format bgra -video_size WxH -i capture.raw`
+			 */
+			struct CaptureInfos {
+				std::string_view path;
+				/// Only every Nth presented frame is written
+				std::uint32_t frameInterval {1};
 			};
 
 			static auto create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window>;
 
+			/// Identifies the window in events
+			[[nodiscard]]
+			auto getId() const noexcept -> lw::WindowId;
+			[[nodiscard]]
+			auto getWidth() const noexcept -> std::uint32_t;
+			[[nodiscard]]
+			auto getHeight() const noexcept -> std::uint32_t;
+			/// Handles stay owned by liteway and are valid as long as the window is
+			[[nodiscard]]
+			auto getNativeHandles() const noexcept -> NativeHandles;
+
+			/// Gives the buffer the next frame is drawn into, allocating it if no released buffer can be reused
+			auto getBackBuffer() noexcept -> lw::Failable<lw::ImageView>;
 			auto fill(const lw::Color& color) noexcept -> lw::Failable<void>;
+			/*
+			 * Attaches the back buffer to the surface and commits it, the requests are sent by the next flush. With
+			 * damage detection, a frame identical to the last one isn't committed at all and no frame becomes pending,
+			 * it is still written to a running capture
+			 */
+			auto present() noexcept -> lw::Failable<void>;
+			/// A frame is pending until the compositor signals it is a good time to draw the next one
+			[[nodiscard]]
+			auto isFramePending() const noexcept -> bool;
+			/// Tiles that changed in the last presented frame, 0 when it was skipped
+			[[nodiscard]]
+			auto getDamagedTileCount() const noexcept -> std::size_t;
+
+			/// Releases the buffers the compositor doesn't use anymore, keeping at most one of them
+			auto trim() noexcept -> void;
+			[[nodiscard]]
+			auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics;
+
+			auto setCursorShape(lw::CursorShape shape) noexcept -> lw::Failable<void>;
+
+			/// Presented buffers are written straight from shared memory and aren't reused until written
+			auto startCapture(const CaptureInfos& captureInfos) noexcept -> lw::Failable<void>;
+			/// Waits for the pending writes and reports the first one that failed
+			auto stopCapture() noexcept -> lw::Failable<void>;
+			[[nodiscard]]
+			auto isCapturing() const noexcept -> bool;
+
+			static auto handleToplevelConfigure(
+				void* data,
+				xdg_toplevel* toplevel,
+				std::int32_t width,
+				std::int32_t height,
+				wl_array* states
+			) noexcept -> void;
+			static auto handleBufferRelease(void* data, wl_buffer* buffer) noexcept -> void;
+			static auto handleFrameDone(void* data, wl_callback* callback, std::uint32_t time) noexcept -> void;
 
 		private:
 			static auto s_createAnonymousFile(std::string_view name, std::size_t size) noexcept -> lw::Failable<int>;
@@ -44,11 +206,19 @@ namespace lw::wayland {
 				wl_shm* sharedMemory,
 				std::uint32_t width, std::uint32_t height
 			) noexcept -> lw::Failable<std::pair<lw::Owned<wl_buffer*>, lw::OwnedSpan<std::byte>>>;
+			static auto s_acquireBuffer(internals::WindowState& state) noexcept -> lw::Failable<internals::Buffer*>;
+			static auto s_destroyBuffer(internals::WindowState& state, internals::Buffer& buffer) noexcept -> void;
+			static auto s_trimBuffers(internals::WindowState& state) noexcept -> void;
+			static auto s_collectCapturedBuffers(internals::WindowState& state) noexcept -> lw::Failable<void>;
+			static auto s_findDamagedTiles(internals::WindowState& state, const internals::Buffer& buffer) noexcept
+				-> void;
+
+			/// Unregisters the window from its instance and destroys everything it owns, leaving it empty
+			auto destroy() noexcept -> void;
 
+			std::unique_ptr<internals::WindowState> m_state;
 			lw::Owned<wl_surface*> m_surface;
 			lw::Owned<xdg_surface*> m_xdgSurface;
 			lw::Owned<xdg_toplevel*> m_toplevel;
-			lw::Owned<wl_buffer*> m_buffer;
-			lw::OwnedSpan<std::byte> m_bufferData;
 	};
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "liteway/backend.hpp"
+#include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/image.hpp"
+#include "liteway/instance.hpp"
+#include "liteway/memory.hpp"
+
+
+namespace lw {
+	/// Backend agnostic window, see `lw::Instance`
+	template <lw::Backend B = lw::backends::Wayland>
+	class Window final {
+		public:
+			using Backend = B;
+
+			Window(const Window&) = delete;
+			auto operator=(const Window&) = delete;
+
+			inline Window() noexcept = default;
+			inline ~Window() = default;
+			inline Window(Window&&) noexcept = default;
+			inline auto operator=(Window&&) noexcept -> Window& = default;
+
+			struct CreateInfos {
+				// NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+				lw::Instance<B>& instance;
+				std::string_view title;
+				std::uint32_t width;
+				std::uint32_t height;
+				/// Maximum amount of buffers in the swapchain, they are only allocated when needed
+				std::size_t bufferCount {2uz};
+			};
+
+			static auto create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window>;
+
+			[[nodiscard]]
+			inline auto getId() const noexcept -> lw::WindowId {return m_backend.getId();}
+			[[nodiscard]]
+			inline auto getWidth() const noexcept -> std::uint32_t {return m_backend.getWidth();}
+			[[nodiscard]]
+			inline auto getHeight() const noexcept -> std::uint32_t {return m_backend.getHeight();}
+
+			inline auto getBackBuffer() noexcept -> lw::Failable<lw::ImageView> {return m_backend.getBackBuffer();}
+			inline auto fill(const lw::Color& color) noexcept -> lw::Failable<void> {return m_backend.fill(color);}
+			inline auto present() noexcept -> lw::Failable<void> {return m_backend.present();}
+			[[nodiscard]]
+			inline auto isFramePending() const noexcept -> bool {return m_backend.isFramePending();}
+
+			inline auto trim() noexcept -> void {m_backend.trim();}
+			[[nodiscard]]
+			inline auto getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+				return m_backend.getMemoryStatistics();
+			}
+
+			inline auto setCursorShape(lw::CursorShape shape) noexcept -> lw::Failable<void> {
+				return m_backend.setCursorShape(shape);
+			}
+
+			[[nodiscard]]
+			inline auto getBackend() noexcept -> typename B::Window& {return m_backend;}
+			[[nodiscard]]
+			inline auto getBackend() const noexcept -> const typename B::Window& {return m_backend;}
+
+		private:
+			typename B::Window m_backend;
+	};
+}
+
+#include "liteway/window.inl"
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <utility>
+
+#include "liteway/window.hpp"
+
+
+namespace lw {
+	template <lw::Backend B>
+	auto Window<B>::create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window> {
+		lw::Failable backendWithError {B::Window::create({
+			.instance = createInfos.instance.getBackend(),
+			.title = createInfos.title,
+			.width = createInfos.width,
+			.height = createInfos.height,
+			.bufferCount = createInfos.bufferCount
+		})};
+		if (!backendWithError)
+			return lw::pushToErrorStack(backendWithError, "Can't create backend window");
+		Window window {};
+		window.m_backend = std::move(*backendWithError);
+		return window;
+	}
+}
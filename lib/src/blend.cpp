@@ -0,0 +1,206 @@
+#include "liteway/blend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define LW_BLEND_X86 1
+#else
+	#define LW_BLEND_X86 0
+#endif
+
+#include "liteway/color.hpp"
+
+
+namespace lw {
+	/*
+	 * Every kernel computes, per channel of premultiplied pixels and with `alpha = coverage * color.a / 255`:
+	 *   out = color * alpha / 255 + destination * (255 - alpha) / 255
+	 * where the color's alpha channel is 255, and each division is the exactly rounded one below
+	 */
+	static constexpr auto divideBy255(std::uint32_t value) noexcept -> std::uint32_t {
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		return (value + 128 + ((value + 128) >> 8)) >> 8;
+	}
+
+	struct BlendColor {
+		/// Channels in memory order, which is BGRA for little endian ARGB8888, with alpha set to 255
+		std::array<std::uint8_t, 4> channels;
+		std::uint8_t alpha;
+	};
+
+	using BlendKernel = auto (*)(std::span<std::uint32_t>, std::span<const std::uint8_t>, const BlendColor&) noexcept
+		-> std::size_t;
+
+
+	/// Returns the amount of pixels it blended, the scalar kernel finishes whatever the vector ones leave
+	static auto blendCoverageScalar(
+		std::span<std::uint32_t> destination,
+		std::span<const std::uint8_t> coverage,
+		const BlendColor& color
+	) noexcept -> std::size_t {
+		for (std::size_t i {0}; i < destination.size(); ++i) {
+			if (coverage[i] == 0)
+				continue;
+			const std::uint32_t alpha {divideBy255(static_cast<std::uint32_t> (coverage[i]) * color.alpha)};
+			std::array<std::uint8_t, 4> pixel {};
+			std::memcpy(pixel.data(), &destination[i], sizeof(std::uint32_t));
+			for (std::size_t channel {0}; channel < pixel.size(); ++channel) {
+				pixel[channel] = static_cast<std::uint8_t> (divideBy255(color.channels[channel] * alpha)
+					+ divideBy255(pixel[channel] * (255 - alpha))
+				);
+			}
+			std::memcpy(&destination[i], pixel.data(), sizeof(std::uint32_t));
+		}
+		return destination.size();
+	}
+
+#if LW_BLEND_X86
+	__attribute__((target("sse2")))
+	static inline auto divideBy255Sse2(__m128i value) noexcept -> __m128i {
+		const __m128i rounded {_mm_add_epi16(value, _mm_set1_epi16(128))};
+		return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+	}
+
+	/// `pixels` are two pixels widened to 16 bits, `coverages` their coverage repeated on their 4 channels
+	__attribute__((target("sse2")))
+	static inline auto blendSse2(__m128i pixels, __m128i coverages, __m128i colorAlpha, __m128i colorChannels)
+		noexcept -> __m128i
+	{
+		const __m128i alpha {divideBy255Sse2(_mm_mullo_epi16(coverages, colorAlpha))};
+		const __m128i source {divideBy255Sse2(_mm_mullo_epi16(colorChannels, alpha))};
+		const __m128i inverseAlpha {_mm_sub_epi16(_mm_set1_epi16(255), alpha)};
+		return _mm_add_epi16(source, divideBy255Sse2(_mm_mullo_epi16(pixels, inverseAlpha)));
+	}
+
+	__attribute__((target("sse2")))
+	static auto blendCoverageSse2(
+		std::span<std::uint32_t> destination,
+		std::span<const std::uint8_t> coverage,
+		const BlendColor& color
+	) noexcept -> std::size_t {
+		constexpr std::size_t pixelsPerStep {4};
+		const __m128i zero {_mm_setzero_si128()};
+		const __m128i colorAlpha {_mm_set1_epi16(color.alpha)};
+		const auto& [b, g, r, a] {color.channels};
+		const __m128i colorChannels {_mm_setr_epi16(b, g, r, a, b, g, r, a)};
+
+		std::size_t i {0};
+		for (; i + pixelsPerStep <= destination.size(); i += pixelsPerStep) {
+			std::int32_t coverageBits {};
+			std::memcpy(&coverageBits, &coverage[i], sizeof(coverageBits));
+			if (coverageBits == 0)
+				continue;
+			__m128i coverageBytes {_mm_cvtsi32_si128(coverageBits)};
+			coverageBytes = _mm_unpacklo_epi8(coverageBytes, coverageBytes);
+			coverageBytes = _mm_unpacklo_epi16(coverageBytes, coverageBytes);
+
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			auto* pixelsAddress {reinterpret_cast<__m128i*> (&destination[i])};
+			const __m128i pixels {_mm_loadu_si128(pixelsAddress)};
+			const __m128i low {blendSse2(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(coverageBytes, zero),
+				colorAlpha, colorChannels
+			)};
+			const __m128i high {blendSse2(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(coverageBytes, zero),
+				colorAlpha, colorChannels
+			)};
+			_mm_storeu_si128(pixelsAddress, _mm_packus_epi16(low, high));
+		}
+		return i;
+	}
+
+	__attribute__((target("avx2")))
+	static inline auto divideBy255Avx2(__m256i value) noexcept -> __m256i {
+		const __m256i rounded {_mm256_add_epi16(value, _mm256_set1_epi16(128))};
+		return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);
+	}
+
+	__attribute__((target("avx2")))
+	static inline auto blendAvx2(__m256i pixels, __m256i coverages, __m256i colorAlpha, __m256i colorChannels)
+		noexcept -> __m256i
+	{
+		const __m256i alpha {divideBy255Avx2(_mm256_mullo_epi16(coverages, colorAlpha))};
+		const __m256i source {divideBy255Avx2(_mm256_mullo_epi16(colorChannels, alpha))};
+		const __m256i inverseAlpha {_mm256_sub_epi16(_mm256_set1_epi16(255), alpha)};
+		return _mm256_add_epi16(source, divideBy255Avx2(_mm256_mullo_epi16(pixels, inverseAlpha)));
+	}
+
+	__attribute__((target("avx2")))
+	static auto blendCoverageAvx2(
+		std::span<std::uint32_t> destination,
+		std::span<const std::uint8_t> coverage,
+		const BlendColor& color
+	) noexcept -> std::size_t {
+		constexpr std::size_t pixelsPerStep {8};
+		const __m256i zero {_mm256_setzero_si256()};
+		const __m256i colorAlpha {_mm256_set1_epi16(color.alpha)};
+		const auto& [b, g, r, a] {color.channels};
+		const __m256i colorChannels {_mm256_setr_epi16(b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a)};
+
+		std::size_t i {0};
+		for (; i + pixelsPerStep <= destination.size(); i += pixelsPerStep) {
+			std::int64_t coverageBits {};
+			std::memcpy(&coverageBits, &coverage[i], sizeof(coverageBits));
+			if (coverageBits == 0)
+				continue;
+			// unpacking works within 128 bits lanes, so pixels 0 to 3 go to the low lane and 4 to 7 to the high one
+			__m128i coverageBytes {_mm_set_epi64x(0, coverageBits)};
+			coverageBytes = _mm_unpacklo_epi8(coverageBytes, coverageBytes);
+			const __m256i coverages {_mm256_set_m128i(
+				_mm_unpackhi_epi16(coverageBytes, coverageBytes),
+				_mm_unpacklo_epi16(coverageBytes, coverageBytes)
+			)};
+
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			auto* pixelsAddress {reinterpret_cast<__m256i*> (&destination[i])};
+			const __m256i pixels {_mm256_loadu_si256(pixelsAddress)};
+			const __m256i low {blendAvx2(_mm256_unpacklo_epi8(pixels, zero), _mm256_unpacklo_epi8(coverages, zero),
+				colorAlpha, colorChannels
+			)};
+			const __m256i high {blendAvx2(_mm256_unpackhi_epi8(pixels, zero), _mm256_unpackhi_epi8(coverages, zero),
+				colorAlpha, colorChannels
+			)};
+			_mm256_storeu_si256(pixelsAddress, _mm256_packus_epi16(low, high));
+		}
+		return i;
+	}
+#endif
+
+	static auto getBlendKernel() noexcept -> BlendKernel {
+	#if LW_BLEND_X86
+		static const BlendKernel kernel {[]() noexcept -> BlendKernel {
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return &blendCoverageAvx2;
+			if (__builtin_cpu_supports("sse2"))
+				return &blendCoverageSse2;
+			return &blendCoverageScalar;
+		} ()};
+		return kernel;
+	#else
+		return &blendCoverageScalar;
+	#endif
+	}
+
+
+	auto blendCoverage(
+		std::span<std::uint32_t> destination,
+		std::span<const std::uint8_t> coverage,
+		const lw::Color& color
+	) noexcept -> void {
+		const std::size_t size {std::min(destination.size(), coverage.size())};
+		destination = destination.first(size);
+		coverage = coverage.first(size);
+		const BlendColor blendColor {
+			.channels = {color.b, color.g, color.r, 255},
+			.alpha = color.a
+		};
+		const std::size_t blendedSize {getBlendKernel()(destination, coverage, blendColor)};
+		blendCoverageScalar(destination.subspan(blendedSize), coverage.subspan(blendedSize), blendColor);
+	}
+}
@@ -0,0 +1,510 @@
+#include "liteway/decoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define LW_DECODER_X86 1
+#else
+	#define LW_DECODER_X86 0
+#endif
+
+#include "liteway/error.hpp"
+#include "liteway/image.hpp"
+#include "liteway/janitor.hpp"
+#include "liteway/trace.hpp"
+
+
+namespace lw {
+	// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+	static constexpr std::size_t qoiHeaderSize {14};
+	/// Seven 0x00 and one 0x01 end every QOI stream
+	static constexpr std::size_t qoiPaddingSize {8};
+	static constexpr std::uint8_t qoiOpRgb {0xfe};
+	static constexpr std::uint8_t qoiOpRgba {0xff};
+	static constexpr std::uint8_t qoiTagMask {0xc0};
+	static constexpr std::uint8_t qoiOpIndex {0x00};
+	static constexpr std::uint8_t qoiOpDiff {0x40};
+	static constexpr std::uint8_t qoiOpLuma {0x80};
+	static constexpr std::uint8_t qoiOpRun {0xc0};
+	// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+	static constexpr auto divideBy255(std::uint32_t value) noexcept -> std::uint32_t {
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		return (value + 128 + ((value + 128) >> 8)) >> 8;
+	}
+
+	static auto getByte(std::span<const std::byte> bytes, std::size_t position) noexcept -> std::uint8_t {
+		return static_cast<std::uint8_t> (bytes[position]);
+	}
+
+	static auto readBigEndian32(std::span<const std::byte> bytes, std::size_t position) noexcept -> std::uint32_t {
+		return (static_cast<std::uint32_t> (getByte(bytes, position)) << 24)
+			| (static_cast<std::uint32_t> (getByte(bytes, position + 1)) << 16)
+			| (static_cast<std::uint32_t> (getByte(bytes, position + 2)) << 8)
+			| static_cast<std::uint32_t> (getByte(bytes, position + 3));
+	}
+
+
+	/*
+	 * Swizzle kernels turn the pixels of the files into premultiplied ARGB8888, which is BGRA in memory. Like
+	 * `lw::blendCoverage`, they return the amount of pixels they converted and the scalar ones finish the rest
+	 */
+	using RgbKernel = auto (*)(std::span<std::uint32_t>, std::span<const std::byte>) noexcept -> std::size_t;
+	/// Works in place, on pixels holding RGBA bytes that aren't premultiplied
+	using RgbaKernel = auto (*)(std::span<std::uint32_t>) noexcept -> std::size_t;
+
+	struct SwizzleKernels {
+		RgbKernel rgb;
+		RgbaKernel rgba;
+	};
+
+
+	static auto swizzleRgbScalar(std::span<std::uint32_t> destination, std::span<const std::byte> source) noexcept
+		-> std::size_t
+	{
+		for (std::size_t i {0}; i < destination.size(); ++i) {
+			destination[i] = 0xff00'0000
+				| (static_cast<std::uint32_t> (getByte(source, 3*i)) << 16)
+				| (static_cast<std::uint32_t> (getByte(source, 3*i + 1)) << 8)
+				| static_cast<std::uint32_t> (getByte(source, 3*i + 2));
+		}
+		return destination.size();
+	}
+
+	static auto swizzleRgbaScalar(std::span<std::uint32_t> pixels) noexcept -> std::size_t {
+		for (std::uint32_t& pixel : pixels) {
+			std::array<std::uint8_t, 4> rgba {};
+			std::memcpy(rgba.data(), &pixel, sizeof(pixel));
+			const auto& [r, g, b, a] {rgba};
+			pixel = (static_cast<std::uint32_t> (a) << 24)
+				| (divideBy255(static_cast<std::uint32_t> (r) * a) << 16)
+				| (divideBy255(static_cast<std::uint32_t> (g) * a) << 8)
+				| divideBy255(static_cast<std::uint32_t> (b) * a);
+		}
+		return pixels.size();
+	}
+
+#if LW_DECODER_X86
+	/// Source bytes of 4 RGB pixels in each 128 bits lane, the alpha bytes are zeroed to be set afterward
+	#define LW_RGB_TO_BGRA_MASK 2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128
+	#define LW_RGBA_TO_BGRA_MASK 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+
+	__attribute__((target("ssse3")))
+	static auto swizzleRgbSsse3(std::span<std::uint32_t> destination, std::span<const std::byte> source) noexcept
+		-> std::size_t
+	{
+		constexpr std::size_t pixelsPerStep {4};
+		const __m128i mask {_mm_setr_epi8(LW_RGB_TO_BGRA_MASK)};
+		const __m128i alpha {_mm_set1_epi32(static_cast<std::int32_t> (0xff00'0000))};
+		std::size_t i {0};
+		// each step loads 16 bytes but only uses 12 of them, the last ones must still be in the source
+		for (; i + pixelsPerStep <= destination.size() && 3*i + sizeof(__m128i) <= source.size(); i += pixelsPerStep) {
+			// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+			const __m128i rgb {_mm_loadu_si128(reinterpret_cast<const __m128i*> (&source[3*i]))};
+			_mm_storeu_si128(reinterpret_cast<__m128i*> (&destination[i]),
+				_mm_or_si128(_mm_shuffle_epi8(rgb, mask), alpha)
+			);
+			// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+		return i;
+	}
+
+	/// `pixels` are two BGRA pixels widened to 16 bits, their color channels are multiplied by their alpha
+	__attribute__((target("ssse3")))
+	static inline auto premultiplySsse3(__m128i pixels) noexcept -> __m128i {
+		const __m128i colorLanes {_mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0)};
+		const __m128i alphaLanes {_mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255)};
+		const __m128i alphas {_mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xff), 0xff)};
+		const __m128i factors {_mm_or_si128(_mm_and_si128(alphas, colorLanes), alphaLanes)};
+		const __m128i rounded {_mm_add_epi16(_mm_mullo_epi16(pixels, factors), _mm_set1_epi16(128))};
+		return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+	}
+
+	__attribute__((target("ssse3")))
+	static auto swizzleRgbaSsse3(std::span<std::uint32_t> pixels) noexcept -> std::size_t {
+		constexpr std::size_t pixelsPerStep {4};
+		const __m128i mask {_mm_setr_epi8(LW_RGBA_TO_BGRA_MASK)};
+		const __m128i zero {_mm_setzero_si128()};
+		std::size_t i {0};
+		for (; i + pixelsPerStep <= pixels.size(); i += pixelsPerStep) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			auto* pixelsAddress {reinterpret_cast<__m128i*> (&pixels[i])};
+			const __m128i bgra {_mm_shuffle_epi8(_mm_loadu_si128(pixelsAddress), mask)};
+			_mm_storeu_si128(pixelsAddress, _mm_packus_epi16(
+				premultiplySsse3(_mm_unpacklo_epi8(bgra, zero)),
+				premultiplySsse3(_mm_unpackhi_epi8(bgra, zero))
+			));
+		}
+		return i;
+	}
+
+	__attribute__((target("avx2")))
+	static auto swizzleRgbAvx2(std::span<std::uint32_t> destination, std::span<const std::byte> source) noexcept
+		-> std::size_t
+	{
+		constexpr std::size_t pixelsPerStep {8};
+		// shuffles stay within 128 bits lanes, so the high lane is loaded from the source of the 5th pixel
+		constexpr std::size_t highLaneOffset {12};
+		const __m256i mask {_mm256_setr_epi8(LW_RGB_TO_BGRA_MASK, LW_RGB_TO_BGRA_MASK)};
+		const __m256i alpha {_mm256_set1_epi32(static_cast<std::int32_t> (0xff00'0000))};
+		std::size_t i {0};
+		for (;
+			i + pixelsPerStep <= destination.size() && 3*i + highLaneOffset + sizeof(__m128i) <= source.size();
+			i += pixelsPerStep
+		) {
+			// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+			const __m256i rgb {_mm256_set_m128i(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*> (&source[3*i + highLaneOffset])),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*> (&source[3*i]))
+			)};
+			_mm256_storeu_si256(reinterpret_cast<__m256i*> (&destination[i]),
+				_mm256_or_si256(_mm256_shuffle_epi8(rgb, mask), alpha)
+			);
+			// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+		return i;
+	}
+
+	__attribute__((target("avx2")))
+	static inline auto premultiplyAvx2(__m256i pixels) noexcept -> __m256i {
+		const __m256i colorLanes {_mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0)};
+		const __m256i alphaLanes {_mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255)};
+		const __m256i alphas {_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, 0xff), 0xff)};
+		const __m256i factors {_mm256_or_si256(_mm256_and_si256(alphas, colorLanes), alphaLanes)};
+		const __m256i rounded {_mm256_add_epi16(_mm256_mullo_epi16(pixels, factors), _mm256_set1_epi16(128))};
+		return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);
+	}
+
+	__attribute__((target("avx2")))
+	static auto swizzleRgbaAvx2(std::span<std::uint32_t> pixels) noexcept -> std::size_t {
+		constexpr std::size_t pixelsPerStep {8};
+		const __m256i mask {_mm256_setr_epi8(LW_RGBA_TO_BGRA_MASK, LW_RGBA_TO_BGRA_MASK)};
+		const __m256i zero {_mm256_setzero_si256()};
+		std::size_t i {0};
+		for (; i + pixelsPerStep <= pixels.size(); i += pixelsPerStep) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			auto* pixelsAddress {reinterpret_cast<__m256i*> (&pixels[i])};
+			const __m256i bgra {_mm256_shuffle_epi8(_mm256_loadu_si256(pixelsAddress), mask)};
+			// unpacking and packing both work within 128 bits lanes, which keeps the pixels in order
+			_mm256_storeu_si256(pixelsAddress, _mm256_packus_epi16(
+				premultiplyAvx2(_mm256_unpacklo_epi8(bgra, zero)),
+				premultiplyAvx2(_mm256_unpackhi_epi8(bgra, zero))
+			));
+		}
+		return i;
+	}
+
+	#undef LW_RGBA_TO_BGRA_MASK
+	#undef LW_RGB_TO_BGRA_MASK
+#endif
+
+	static auto getSwizzleKernels() noexcept -> SwizzleKernels {
+	#if LW_DECODER_X86
+		static const SwizzleKernels kernels {[]() noexcept -> SwizzleKernels {
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return {.rgb = &swizzleRgbAvx2, .rgba = &swizzleRgbaAvx2};
+			if (__builtin_cpu_supports("ssse3"))
+				return {.rgb = &swizzleRgbSsse3, .rgba = &swizzleRgbaSsse3};
+			return {.rgb = &swizzleRgbScalar, .rgba = &swizzleRgbaScalar};
+		} ()};
+		return kernels;
+	#else
+		return {.rgb = &swizzleRgbScalar, .rgba = &swizzleRgbaScalar};
+	#endif
+	}
+
+
+	static auto isPpmWhitespace(char character) noexcept -> bool {
+		return character == ' ' || character == '\t' || character == '\n' || character == '\r'
+			|| character == '\v' || character == '\f';
+	}
+
+	/// Reads the next decimal number of a PPM header, skipping the whitespaces and comments before it
+	static auto readPpmNumber(std::span<const std::byte> file, std::size_t& position) noexcept
+		-> lw::Failable<std::uint32_t>
+	{
+		for (;;) {
+			if (position >= file.size())
+				return lw::makeErrorStack("PPM header ends before its last number");
+			const char character {static_cast<char> (getByte(file, position))};
+			if (character == '#') {
+				while (position < file.size() && getByte(file, position) != '\n')
+					++position;
+				continue;
+			}
+			if (!isPpmWhitespace(character))
+				break;
+			++position;
+		}
+
+		std::uint32_t number {0};
+		const std::size_t start {position};
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		constexpr std::uint32_t maxNumber {1u << 24};
+		while (position < file.size() && getByte(file, position) >= '0' && getByte(file, position) <= '9') {
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+			number = number * 10 + (getByte(file, position) - '0');
+			if (number > maxNumber)
+				return lw::makeErrorStack("PPM header holds a number bigger than {}", maxNumber);
+			++position;
+		}
+		if (position == start)
+			return lw::makeErrorStack("PPM header holds '{}' where a number was expected",
+				static_cast<char> (getByte(file, position))
+			);
+		return number;
+	}
+
+
+	ImageDecoder::~ImageDecoder() {
+		if (m_file.data() != nullptr)
+			munmap(m_file.data(), m_file.size());
+	}
+
+
+	auto ImageDecoder::operator=(ImageDecoder&& other) noexcept -> ImageDecoder& {
+		if (this == &other)
+			return *this;
+		// moving an `OwnedSpan` only overwrites its pointers, the mapping it held would leak
+		if (m_file.data() != nullptr)
+			munmap(m_file.data(), m_file.size());
+		m_file = std::move(other.m_file);
+		m_infos = other.m_infos;
+		m_position = other.m_position;
+		m_decodedRowCount = other.m_decodedRowCount;
+		m_maxValue = other.m_maxValue;
+		m_qoi = other.m_qoi;
+		m_hasFailed = other.m_hasFailed;
+		return *this;
+	}
+
+
+	auto ImageDecoder::create(const CreateInfos& createInfos) noexcept -> lw::Failable<ImageDecoder> {
+		const lw::trace::Scope traceScope {"ImageDecoder::create"};
+		const bool ownsFd {createInfos.fd == -1};
+		int fd {createInfos.fd};
+		if (ownsFd) {
+			const std::string path {createInfos.path};
+			fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return lw::makeErrorStack("Can't open image '{}' : {}", createInfos.path, strerror(errno));
+		}
+		// the mapping stays valid once the fd is closed
+		lw::Janitor _ {[fd, ownsFd]() noexcept {
+			if (ownsFd)
+				close(fd);
+		}};
+
+		struct stat fileStatus {};
+		if (fstat(fd, &fileStatus) != 0)
+			return lw::makeErrorStack("Can't get status of image file : {}", strerror(errno));
+		if (!S_ISREG(fileStatus.st_mode))
+			return lw::makeErrorStack("Image must be a regular file so it can be mapped");
+		if (fileStatus.st_size <= 0)
+			return lw::makeErrorStack("Image file is empty");
+		const auto size {static_cast<std::size_t> (fileStatus.st_size)};
+
+		void* mapping {mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+		if (mapping == MAP_FAILED)
+			return lw::makeErrorStack("Can't map image file : {}", strerror(errno));
+		// rows are decoded front to back, the kernel can read ahead and drop the pages behind
+		static_cast<void> (madvise(mapping, size, MADV_SEQUENTIAL));
+		ImageDecoder decoder {};
+		decoder.m_file = lw::OwnedSpan{static_cast<std::byte*> (mapping), size};
+		const std::span<const std::byte> file {decoder.m_file.data(), decoder.m_file.size()};
+
+		const auto startsWith {[&file](std::string_view magic) noexcept -> bool {
+			return file.size() >= magic.size()
+				&& std::memcmp(file.data(), magic.data(), magic.size()) == 0;
+		}};
+
+		if (startsWith("qoif")) {
+			if (file.size() < qoiHeaderSize + qoiPaddingSize)
+				return lw::makeErrorStack("QOI file of {} bytes is too small to hold an image", file.size());
+			const std::uint8_t channels {getByte(file, 12)};
+			if (channels != 3 && channels != 4)
+				return lw::makeErrorStack("QOI image has {} channels instead of 3 or 4", channels);
+			decoder.m_infos = {
+				.format = ImageFormat::qoi,
+				.width = readBigEndian32(file, 4),
+				.height = readBigEndian32(file, 8)
+			};
+			decoder.m_position = qoiHeaderSize;
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+			decoder.m_qoi = {.index = {}, .previous = {0, 0, 0, 255}, .run = 0};
+		}
+		else if (startsWith("P6")) {
+			std::size_t position {2};
+			std::array<std::uint32_t, 3> numbers {};
+			for (std::uint32_t& number : numbers) {
+				lw::Failable numberWithError {readPpmNumber(file, position)};
+				if (!numberWithError)
+					return lw::pushToErrorStack(numberWithError, "Can't read PPM header");
+				number = *numberWithError;
+			}
+			const auto [width, height, maxValue] {numbers};
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+			if (maxValue == 0 || maxValue > 255)
+				return lw::makeErrorStack("PPM images with a maximum value of {} aren't supported", maxValue);
+			// a single whitespace separates the header from the pixels
+			if (position >= file.size() || !isPpmWhitespace(static_cast<char> (getByte(file, position))))
+				return lw::makeErrorStack("PPM header isn't followed by a whitespace before its pixels");
+			decoder.m_infos = {.format = ImageFormat::ppm, .width = width, .height = height};
+			decoder.m_position = position + 1;
+			decoder.m_maxValue = maxValue;
+			if (decoder.m_position + 3ull * width * height > file.size())
+				return lw::makeErrorStack("PPM file of {} bytes is too small for a {}x{} image",
+					file.size(), width, height
+				);
+		}
+		else
+			return lw::makeErrorStack("Image is neither a QOI nor a binary PPM file");
+
+		if (decoder.m_infos.width == 0 || decoder.m_infos.height == 0)
+			return lw::makeErrorStack("Image is empty");
+		return decoder;
+	}
+
+
+	auto ImageDecoder::getInfos() const noexcept -> ImageInfos {
+		return m_infos;
+	}
+
+
+	auto ImageDecoder::getDecodedRowCount() const noexcept -> std::uint32_t {
+		return m_decodedRowCount;
+	}
+
+
+	auto ImageDecoder::decodeRows(const lw::ImageView& destination) noexcept -> lw::Failable<std::uint32_t> {
+		const lw::trace::Scope traceScope {"ImageDecoder::decodeRows"};
+		if (m_hasFailed)
+			return lw::makeErrorStack("Decoder can't resume after failing to decode row {}", m_decodedRowCount);
+		if (destination.width < m_infos.width)
+			return lw::makeErrorStack("Destination is {} pixels wide, narrower than the {} pixels of the image",
+				destination.width, m_infos.width
+			);
+
+		const std::uint32_t rowCount {std::min(destination.height, m_infos.height - m_decodedRowCount)};
+		for (std::uint32_t y {0}; y < rowCount; ++y) {
+			const std::span<std::uint32_t> row {destination.row(y).first(m_infos.width)};
+			lw::Failable rowResult {m_infos.format == ImageFormat::qoi
+				? this->decodeQoiRow(row)
+				: this->decodePpmRow(row)
+			};
+			if (!rowResult) {
+				// the failed row already moved through the file, so the next one can't be decoded anymore
+				m_hasFailed = true;
+				return lw::pushToErrorStack(rowResult, "Can't decode row {} of image", m_decodedRowCount);
+			}
+			++m_decodedRowCount;
+		}
+		return rowCount;
+	}
+
+
+	auto ImageDecoder::decodeQoiRow(std::span<std::uint32_t> row) noexcept -> lw::Failable<void> {
+		// the padding can't start a chunk, which also lets chunks read up to 4 bytes past their tag unchecked
+		const std::span<const std::byte> chunks {m_file.data(), m_file.size() - qoiPaddingSize};
+		const std::span<const std::byte> file {m_file.data(), m_file.size()};
+		Rgba& pixel {m_qoi.previous};
+
+		for (std::uint32_t& destination : row) {
+			if (m_qoi.run > 0)
+				--m_qoi.run;
+			else {
+				if (m_position >= chunks.size())
+					return lw::makeErrorStack("QOI data ends before the last pixel");
+				const std::uint8_t tag {getByte(file, m_position++)};
+				if (tag == qoiOpRgb) {
+					for (std::size_t channel {0}; channel < 3; ++channel)
+						pixel[channel] = getByte(file, m_position++);
+				}
+				else if (tag == qoiOpRgba) {
+					for (std::uint8_t& channel : pixel)
+						channel = getByte(file, m_position++);
+				}
+				else {
+					// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+					switch (static_cast<std::uint8_t> (tag & qoiTagMask)) {
+						case qoiOpIndex:
+							pixel = m_qoi.index[tag];
+							break;
+						case qoiOpDiff:
+							pixel[0] = static_cast<std::uint8_t> (pixel[0] + ((tag >> 4) & 0x03) - 2);
+							pixel[1] = static_cast<std::uint8_t> (pixel[1] + ((tag >> 2) & 0x03) - 2);
+							pixel[2] = static_cast<std::uint8_t> (pixel[2] + (tag & 0x03) - 2);
+							break;
+						case qoiOpLuma: {
+							const std::uint8_t differences {getByte(file, m_position++)};
+							const int greenDifference {(tag & 0x3f) - 32};
+							const int redDifference {greenDifference - 8 + (differences >> 4)};
+							const int blueDifference {greenDifference - 8 + (differences & 0x0f)};
+							pixel[0] = static_cast<std::uint8_t> (pixel[0] + redDifference);
+							pixel[1] = static_cast<std::uint8_t> (pixel[1] + greenDifference);
+							pixel[2] = static_cast<std::uint8_t> (pixel[2] + blueDifference);
+							break;
+						}
+						case qoiOpRun:
+						default:
+							m_qoi.run = tag & 0x3f;
+							break;
+					}
+				}
+				const std::size_t hash {(pixel[0] * 3uz + pixel[1] * 5uz + pixel[2] * 7uz + pixel[3] * 11uz) % 64uz};
+				// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+				m_qoi.index[hash] = pixel;
+			}
+			std::memcpy(&destination, pixel.data(), sizeof(destination));
+		}
+
+		const std::size_t swizzledSize {getSwizzleKernels().rgba(row)};
+		swizzleRgbaScalar(row.subspan(swizzledSize));
+		return {};
+	}
+
+
+	auto ImageDecoder::decodePpmRow(std::span<std::uint32_t> row) noexcept -> lw::Failable<void> {
+		// the whole image was checked to fit in the file, and vector kernels may read past the row
+		const std::span<const std::byte> pixels {std::span<const std::byte> {m_file.data(), m_file.size()}
+			.subspan(m_position)
+		};
+		m_position += 3uz * row.size();
+
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		if (m_maxValue == 255) {
+			const std::size_t swizzledSize {getSwizzleKernels().rgb(row, pixels)};
+			swizzleRgbScalar(row.subspan(swizzledSize), pixels.subspan(3 * swizzledSize));
+			return {};
+		}
+
+		// less common depths are scaled to 8 bits on the scalar path
+		const auto scale {[this](std::uint8_t value) noexcept -> std::uint32_t {
+			// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+			return std::min((static_cast<std::uint32_t> (value) * 255 + m_maxValue / 2) / m_maxValue, 255u);
+		}};
+		for (std::size_t i {0}; i < row.size(); ++i) {
+			row[i] = 0xff00'0000
+				| (scale(getByte(pixels, 3*i)) << 16)
+				| (scale(getByte(pixels, 3*i + 1)) << 8)
+				| scale(getByte(pixels, 3*i + 2));
+		}
+		return {};
+	}
+}
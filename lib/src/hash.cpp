@@ -0,0 +1,162 @@
+#include "liteway/hash.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define LW_HASH_X86 1
+#else
+	#define LW_HASH_X86 0
+#endif
+
+#include "liteway/image.hpp"
+
+
+namespace lw {
+	/*
+	 * Every row is cut in blocks of four 64 bits words, each going to its own lane, in the spirit of XXH3:
+	 *   keyed = word ^ key
+	 *   lane += low32(keyed) * high32(keyed) + word
+	 * Keys change from one block to the next so moving blocks around changes the hash, and lanes are scrambled
+	 * after every row for the same reason. Only 32x32 bits multiplications are used as SSE2 and AVX2 lack wider ones
+	 */
+	static constexpr std::size_t laneCount {4};
+	static constexpr std::size_t pixelsPerBlock {laneCount * sizeof(std::uint64_t) / sizeof(std::uint32_t)};
+	// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+	static constexpr std::array<std::uint64_t, laneCount> initialKeys {
+		0xbe4ba423396cfeb8, 0x1cad21f72c81017c, 0xdb979083e96dd4de, 0x1f67b3b7a4a44072
+	};
+	static constexpr std::uint64_t keyStep {0x9e3779b97f4a7c15};
+	static constexpr std::uint32_t scramblePrime {0x9e3779b1};
+	static constexpr std::uint64_t tailPrime {0x100000001b3};
+	// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+	using Lanes = std::array<std::uint64_t, laneCount>;
+	/// Returns the amount of pixels of the row it hashed, which is always a multiple of `pixelsPerBlock`
+	using HashKernel = auto (*)(std::span<const std::uint32_t>, Lanes&) noexcept -> std::size_t;
+
+
+	static auto hashBlocksScalar(std::span<const std::uint32_t> row, Lanes& lanes) noexcept -> std::size_t {
+		Lanes keys {initialKeys};
+		std::size_t i {0};
+		for (; i + pixelsPerBlock <= row.size(); i += pixelsPerBlock) {
+			std::array<std::uint64_t, laneCount> words {};
+			std::memcpy(words.data(), &row[i], sizeof(words));
+			for (std::size_t lane {0}; lane < laneCount; ++lane) {
+				const std::uint64_t keyed {words[lane] ^ keys[lane]};
+				lanes[lane] += (keyed & 0xffff'ffff) * (keyed >> 32) + words[lane];
+				keys[lane] += keyStep;
+			}
+		}
+		return i;
+	}
+
+#if LW_HASH_X86
+	__attribute__((target("sse2")))
+	static inline auto accumulateSse2(__m128i lanes, __m128i words, __m128i keys) noexcept -> __m128i {
+		const __m128i keyed {_mm_xor_si128(words, keys)};
+		const __m128i product {_mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32))};
+		return _mm_add_epi64(lanes, _mm_add_epi64(product, words));
+	}
+
+	__attribute__((target("sse2")))
+	static auto hashBlocksSse2(std::span<const std::uint32_t> row, Lanes& lanes) noexcept -> std::size_t {
+		const __m128i step {_mm_set1_epi64x(static_cast<std::int64_t> (keyStep))};
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		__m128i keysLow {_mm_loadu_si128(reinterpret_cast<const __m128i*> (&initialKeys[0]))};
+		__m128i keysHigh {_mm_loadu_si128(reinterpret_cast<const __m128i*> (&initialKeys[2]))};
+		__m128i lanesLow {_mm_loadu_si128(reinterpret_cast<const __m128i*> (&lanes[0]))};
+		__m128i lanesHigh {_mm_loadu_si128(reinterpret_cast<const __m128i*> (&lanes[2]))};
+
+		std::size_t i {0};
+		for (; i + pixelsPerBlock <= row.size(); i += pixelsPerBlock) {
+			const auto* words {reinterpret_cast<const __m128i*> (&row[i])};
+			lanesLow = accumulateSse2(lanesLow, _mm_loadu_si128(words), keysLow);
+			lanesHigh = accumulateSse2(lanesHigh, _mm_loadu_si128(words + 1), keysHigh);
+			keysLow = _mm_add_epi64(keysLow, step);
+			keysHigh = _mm_add_epi64(keysHigh, step);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*> (&lanes[0]), lanesLow);
+		_mm_storeu_si128(reinterpret_cast<__m128i*> (&lanes[2]), lanesHigh);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		return i;
+	}
+
+	__attribute__((target("avx2")))
+	static auto hashBlocksAvx2(std::span<const std::uint32_t> row, Lanes& lanes) noexcept -> std::size_t {
+		const __m256i step {_mm256_set1_epi64x(static_cast<std::int64_t> (keyStep))};
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		__m256i keys {_mm256_loadu_si256(reinterpret_cast<const __m256i*> (initialKeys.data()))};
+		__m256i accumulators {_mm256_loadu_si256(reinterpret_cast<const __m256i*> (lanes.data()))};
+
+		std::size_t i {0};
+		for (; i + pixelsPerBlock <= row.size(); i += pixelsPerBlock) {
+			const __m256i words {_mm256_loadu_si256(reinterpret_cast<const __m256i*> (&row[i]))};
+			const __m256i keyed {_mm256_xor_si256(words, keys)};
+			const __m256i product {_mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32))};
+			accumulators = _mm256_add_epi64(accumulators, _mm256_add_epi64(product, words));
+			keys = _mm256_add_epi64(keys, step);
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*> (lanes.data()), accumulators);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		return i;
+	}
+#endif
+
+	static auto getHashKernel() noexcept -> HashKernel {
+	#if LW_HASH_X86
+		static const HashKernel kernel {[]() noexcept -> HashKernel {
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return &hashBlocksAvx2;
+			if (__builtin_cpu_supports("sse2"))
+				return &hashBlocksSse2;
+			return &hashBlocksScalar;
+		} ()};
+		return kernel;
+	#else
+		return &hashBlocksScalar;
+	#endif
+	}
+
+	/// MurmurHash3's finalizer
+	static constexpr auto mix(std::uint64_t value) noexcept -> std::uint64_t {
+		// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccd;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53;
+		value ^= value >> 33;
+		// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+		return value;
+	}
+
+
+	auto hashImage(const lw::ImageView& image) noexcept -> std::uint64_t {
+		const HashKernel kernel {getHashKernel()};
+		Lanes lanes {};
+		for (std::uint32_t y {0}; y < image.height; ++y) {
+			const std::span<const std::uint32_t> row {image.row(y)};
+			const std::size_t hashedSize {kernel(row, lanes)};
+			for (const std::uint32_t pixel : row.subspan(hashedSize))
+				lanes[0] = (lanes[0] ^ pixel) * tailPrime;
+			// equivalent to the 32 bits multiplications XXH3 scrambles with
+			for (std::uint64_t& lane : lanes) {
+				// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+				lane ^= lane >> 47;
+				lane *= scramblePrime;
+			}
+		}
+
+		std::uint64_t hash {mix((static_cast<std::uint64_t> (image.width) << 32) | image.height)};
+		for (const std::uint64_t lane : lanes)
+			hash = mix(hash ^ lane);
+		return hash;
+	}
+}
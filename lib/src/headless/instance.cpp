@@ -0,0 +1,100 @@
+#include "liteway/headless/instance.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/headless/window.hpp"
+#include "liteway/memory.hpp"
+#include "liteway/trace.hpp"
+
+
+namespace lw::headless {
+	static constexpr std::uint64_t nanosecondsPerSecond {1'000'000'000};
+
+	static auto getMonotonicTime() noexcept -> std::uint64_t {
+		timespec time {};
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return static_cast<std::uint64_t> (time.tv_sec) * nanosecondsPerSecond
+			+ static_cast<std::uint64_t> (time.tv_nsec);
+	}
+
+
+	Instance::~Instance() = default;
+
+
+	auto Instance::create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance> {
+		const lw::trace::Scope traceScope {"headless::Instance::create"};
+		const std::uint64_t frameInterval {createInfos.frameRate == 0
+			? 0
+			: nanosecondsPerSecond / createInfos.frameRate
+		};
+		Instance instance {};
+		instance.m_state = std::make_unique<internals::InstanceState> (internals::InstanceState{
+			.frameInterval = frameInterval,
+			.nextFrameTimestamp = getMonotonicTime() + frameInterval,
+			.nextWindowId = 1,
+			.events = {},
+			.windows = {},
+			.memoryStatistics = {}
+		});
+		return instance;
+	}
+
+
+	auto Instance::update() noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"headless::Instance::update"};
+		if (m_state->frameInterval != 0) {
+			const timespec nextFrame {
+				.tv_sec = static_cast<time_t> (m_state->nextFrameTimestamp / nanosecondsPerSecond),
+				.tv_nsec = static_cast<long> (m_state->nextFrameTimestamp % nanosecondsPerSecond)
+			};
+			int result {};
+			while ((result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextFrame, nullptr)) == EINTR);
+			if (result != 0)
+				return lw::makeErrorStack("Can't wait for the next simulated frame : error {}", result);
+
+			// ticks missed by a slow frame are skipped rather than completed in a burst
+			const std::uint64_t now {getMonotonicTime()};
+			m_state->nextFrameTimestamp += m_state->frameInterval;
+			if (m_state->nextFrameTimestamp <= now)
+				m_state->nextFrameTimestamp = now + m_state->frameInterval;
+		}
+
+		for (internals::WindowState* window : m_state->windows) {
+			if (!std::exchange(window->isFramePending, false))
+				continue;
+			lw::trace::instant("headless::Window::frameDone");
+		}
+		return {};
+	}
+
+
+	auto Instance::flush() noexcept -> lw::Failable<void> {
+		return {};
+	}
+
+
+	auto Instance::pollEvent() noexcept -> std::optional<lw::Event> {
+		if (m_state->events.empty())
+			return std::nullopt;
+		lw::Event event {std::move(m_state->events.front())};
+		m_state->events.pop_front();
+		return event;
+	}
+
+
+	auto Instance::getInputState() const noexcept -> lw::InputState {
+		return lw::InputState{};
+	}
+
+
+	auto Instance::getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+		return m_state->memoryStatistics;
+	}
+}
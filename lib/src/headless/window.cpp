@@ -0,0 +1,205 @@
+#include "liteway/headless/window.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/headless/instance.hpp"
+#include "liteway/image.hpp"
+#include "liteway/memory.hpp"
+#include "liteway/trace.hpp"
+
+
+namespace lw::headless {
+	Window::~Window() {
+		this->destroy();
+	}
+
+
+	auto Window::operator=(Window&& other) noexcept -> Window& {
+		if (this == &other)
+			return *this;
+		// the instance still walks the old state, so it can't just be dropped
+		this->destroy();
+		m_state = std::move(other.m_state);
+		return *this;
+	}
+
+
+	auto Window::destroy() noexcept -> void {
+		if (!m_state)
+			return;
+		std::erase(m_state->instance.windows, m_state.get());
+		while (!m_state->buffers.empty())
+			Window::s_destroyBuffer(*m_state, *m_state->buffers.back());
+		m_state.reset();
+	}
+
+
+	auto Window::create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window> {
+		if (createInfos.bufferCount == 0)
+			return lw::makeErrorStack("A window needs at least one buffer");
+		internals::InstanceState& instanceState {*createInfos.instance.m_state};
+		Window window {};
+		window.m_state = std::make_unique<internals::WindowState> (internals::WindowState{
+			.instance = instanceState,
+			.id = static_cast<lw::WindowId> (instanceState.nextWindowId++),
+			.name = std::string{createInfos.title},
+			.width = createInfos.width,
+			.height = createInfos.height,
+			.maxBufferCount = createInfos.bufferCount,
+			.buffers = {}
+		});
+		instanceState.windows.push_back(window.m_state.get());
+		return window;
+	}
+
+
+	auto Window::getId() const noexcept -> lw::WindowId {
+		return m_state->id;
+	}
+
+
+	auto Window::getWidth() const noexcept -> std::uint32_t {
+		return m_state->width;
+	}
+
+
+	auto Window::getHeight() const noexcept -> std::uint32_t {
+		return m_state->height;
+	}
+
+
+	auto Window::getBackBuffer() noexcept -> lw::Failable<lw::ImageView> {
+		if (m_state->backBuffer == nullptr) {
+			lw::Failable bufferWithError {Window::s_acquireBuffer(*m_state)};
+			if (!bufferWithError)
+				return lw::pushToErrorStack(bufferWithError, "Can't acquire a buffer to draw into");
+			m_state->backBuffer = *bufferWithError;
+		}
+		return lw::ImageView{
+			.pixels = m_state->backBuffer->pixels,
+			.width = m_state->width,
+			.height = m_state->height,
+			.stride = m_state->width
+		};
+	}
+
+
+	auto Window::fill(const lw::Color& color) noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"headless::Window::fill"};
+		lw::Failable backBufferWithError {this->getBackBuffer()};
+		if (!backBufferWithError)
+			return lw::pushToErrorStack(backBufferWithError, "Can't get back buffer to fill");
+		std::ranges::fill(backBufferWithError->pixels, colorToUint32(color));
+		return {};
+	}
+
+
+	auto Window::present() noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"headless::Window::present"};
+		if (m_state->backBuffer == nullptr)
+			return lw::makeErrorStack("Can't present a window that has nothing drawn into its back buffer");
+		for (auto& buffer : m_state->buffers)
+			buffer->isFront = false;
+		m_state->backBuffer->isFront = true;
+		m_state->backBuffer = nullptr;
+		m_state->isFramePending = true;
+		return {};
+	}
+
+
+	auto Window::isFramePending() const noexcept -> bool {
+		return m_state->isFramePending;
+	}
+
+
+	auto Window::getFrontBuffer() const noexcept -> std::optional<lw::ImageView> {
+		const auto frontBuffer {std::ranges::find_if(m_state->buffers, [](const auto& buffer) noexcept {
+			return buffer->isFront;
+		})};
+		if (frontBuffer == m_state->buffers.end())
+			return std::nullopt;
+		return lw::ImageView{
+			.pixels = (*frontBuffer)->pixels,
+			.width = m_state->width,
+			.height = m_state->height,
+			.stride = m_state->width
+		};
+	}
+
+
+	auto Window::trim() noexcept -> void {
+		for (std::size_t i {m_state->buffers.size()}; i > 0 && m_state->buffers.size() > 1; --i) {
+			internals::Buffer& buffer {*m_state->buffers[i - 1]};
+			if (!buffer.isFront && &buffer != m_state->backBuffer)
+				Window::s_destroyBuffer(*m_state, buffer);
+		}
+	}
+
+
+	auto Window::getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+		return m_state->memoryStatistics;
+	}
+
+
+	auto Window::setCursorShape([[maybe_unused]] lw::CursorShape shape) noexcept -> lw::Failable<void> {
+		return {};
+	}
+
+
+	auto Window::s_acquireBuffer(internals::WindowState& state) noexcept -> lw::Failable<internals::Buffer*> {
+		// like a compositor, the front buffer is only given back once the next present replaces it
+		const auto freeBuffer {std::ranges::find_if(state.buffers, [](const auto& buffer) noexcept {
+			return !buffer->isFront;
+		})};
+		if (freeBuffer != state.buffers.end())
+			return freeBuffer->get();
+		if (state.buffers.size() >= state.maxBufferCount) {
+			// a single buffered swapchain can only draw over its front buffer, once it has been shown
+			if (state.buffers.size() == 1 && !state.isFramePending)
+				return state.buffers.front().get();
+			return lw::makeErrorStack("All {} buffers of the swapchain are in use", state.buffers.size());
+		}
+
+		const lw::trace::Scope traceScope {"headless::Window::createBuffer"};
+		const std::size_t pixelCount {static_cast<std::size_t> (state.width) * state.height};
+		auto& newBuffer {*state.buffers.emplace_back(std::make_unique<internals::Buffer> (internals::Buffer{
+			.pixels = std::vector<std::uint32_t> (pixelCount),
+			.isFront = false
+		}))};
+
+		const lw::MemoryStatistics bufferStatistics {
+			.mappedBytes = pixelCount * sizeof(std::uint32_t),
+			.bufferCount = 1uz,
+			.poolBytes = 0uz
+		};
+		state.memoryStatistics += bufferStatistics;
+		state.instance.memoryStatistics += bufferStatistics;
+		return &newBuffer;
+	}
+
+
+	auto Window::s_destroyBuffer(internals::WindowState& state, internals::Buffer& buffer) noexcept -> void {
+		const lw::MemoryStatistics bufferStatistics {
+			.mappedBytes = buffer.pixels.size() * sizeof(std::uint32_t),
+			.bufferCount = 1uz,
+			.poolBytes = 0uz
+		};
+		state.memoryStatistics -= bufferStatistics;
+		state.instance.memoryStatistics -= bufferStatistics;
+		if (state.backBuffer == &buffer)
+			state.backBuffer = nullptr;
+		std::erase_if(state.buffers, [&buffer](const auto& ownedBuffer) noexcept {
+			return ownedBuffer.get() == &buffer;
+		});
+	}
+}
@@ -1,6 +0,0 @@
-#include "liteway/instance.hpp"
-
-
-namespace lw {
-
-}
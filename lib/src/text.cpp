@@ -0,0 +1,237 @@
+#include "liteway/text.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "liteway/blend.hpp"
+#include "liteway/color.hpp"
+#include "liteway/error.hpp"
+#include "liteway/image.hpp"
+#include "liteway/trace.hpp"
+
+
+namespace lw {
+	static constexpr char32_t replacementCharacter {U'\uFFFD'};
+
+	/// Decodes the first codepoint of `text` and removes it from the view
+	static auto decodeUtf8(std::string_view& text) noexcept -> char32_t {
+		// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+		constexpr std::array<char32_t, 5> minimumCodepoints {0, 0, 0x80, 0x800, 0x10000};
+		const auto lead {static_cast<std::uint8_t> (text.front())};
+		std::size_t length {};
+		char32_t codepoint {};
+		if (lead < 0x80) {
+			text.remove_prefix(1);
+			return lead;
+		}
+		if ((lead & 0xE0) == 0xC0) {
+			length = 2;
+			codepoint = lead & 0x1F;
+		}
+		else if ((lead & 0xF0) == 0xE0) {
+			length = 3;
+			codepoint = lead & 0x0F;
+		}
+		else if ((lead & 0xF8) == 0xF0) {
+			length = 4;
+			codepoint = lead & 0x07;
+		}
+		else {
+			text.remove_prefix(1);
+			return replacementCharacter;
+		}
+
+		for (std::size_t i {1}; i < length; ++i) {
+			if (i >= text.size() || (static_cast<std::uint8_t> (text[i]) & 0xC0) != 0x80) {
+				text.remove_prefix(i);
+				return replacementCharacter;
+			}
+			codepoint = (codepoint << 6) | (static_cast<std::uint8_t> (text[i]) & 0x3F);
+		}
+		text.remove_prefix(length);
+		const bool isSurrogate {codepoint >= 0xD800 && codepoint <= 0xDFFF};
+		if (codepoint < minimumCodepoints[length] || codepoint > 0x10FFFF || isSurrogate)
+			return replacementCharacter;
+		return codepoint;
+		// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+	}
+
+
+	auto GlyphCache::GlyphKeyHash::operator()(const GlyphKey& key) const noexcept -> std::size_t {
+		const std::uint64_t packedKey {(static_cast<std::uint64_t> (key.font) << 32uz)
+			^ (static_cast<std::uint64_t> (key.size) << 21uz)
+			^ static_cast<std::uint64_t> (key.codepoint)
+		};
+		return std::hash<std::uint64_t> {} (packedKey);
+	}
+
+
+	auto GlyphCache::create(CreateInfos&& createInfos) noexcept -> lw::Failable<GlyphCache> {
+		if (!createInfos.rasterizer)
+			return lw::makeErrorStack("Glyph cache needs a rasterizer");
+		if (createInfos.atlasWidth == 0 || createInfos.atlasHeight == 0)
+			return lw::makeErrorStack("Glyph atlas can't be empty");
+		GlyphCache cache {};
+		cache.m_rasterizer = std::move(createInfos.rasterizer);
+		cache.m_atlasWidth = createInfos.atlasWidth;
+		cache.m_atlasHeight = createInfos.atlasHeight;
+		cache.m_atlas.resize(static_cast<std::size_t> (createInfos.atlasWidth) * createInfos.atlasHeight);
+		return cache;
+	}
+
+
+	auto GlyphCache::drawText(const lw::ImageView& target, const TextInfos& textInfos) noexcept
+		-> lw::Failable<float>
+	{
+		const lw::trace::Scope traceScope {"GlyphCache::drawText"};
+		auto penX {static_cast<float> (textInfos.x)};
+		std::string_view text {textInfos.text};
+		while (!text.empty()) {
+			const char32_t codepoint {decodeUtf8(text)};
+			lw::Failable glyphWithError {this->getGlyph({textInfos.font, textInfos.size, codepoint})};
+			if (!glyphWithError)
+				return lw::pushToErrorStack(glyphWithError, "Can't get glyph to draw");
+			const Glyph& glyph {**glyphWithError};
+
+			const std::int64_t left {std::lround(penX) + glyph.bearingX};
+			const std::int64_t top {static_cast<std::int64_t> (textInfos.y) - glyph.bearingY};
+			const std::int64_t clippedLeft {std::max<std::int64_t> (left, 0)};
+			const std::int64_t clippedTop {std::max<std::int64_t> (top, 0)};
+			const std::int64_t clippedRight {std::min<std::int64_t> (left + glyph.width, target.width)};
+			const std::int64_t clippedBottom {std::min<std::int64_t> (top + glyph.height, target.height)};
+			penX += glyph.advance;
+			if (clippedLeft >= clippedRight)
+				continue;
+
+			const auto width {static_cast<std::size_t> (clippedRight - clippedLeft)};
+			for (std::int64_t y {clippedTop}; y < clippedBottom; ++y) {
+				const std::size_t atlasOffset {
+					static_cast<std::size_t> (glyph.atlasY + static_cast<std::uint32_t> (y - top)) * m_atlasWidth
+					+ glyph.atlasX + static_cast<std::size_t> (clippedLeft - left)
+				};
+				lw::blendCoverage(
+					target.row(static_cast<std::uint32_t> (y)).subspan(static_cast<std::size_t> (clippedLeft), width),
+					std::span{m_atlas}.subspan(atlasOffset, width),
+					textInfos.color
+				);
+			}
+		}
+		return penX;
+	}
+
+
+	auto GlyphCache::measureText(lw::FontId font, std::uint32_t size, std::string_view text) noexcept
+		-> lw::Failable<float>
+	{
+		float width {0.f};
+		while (!text.empty()) {
+			lw::Failable glyphWithError {this->getGlyph({font, size, decodeUtf8(text)})};
+			if (!glyphWithError)
+				return lw::pushToErrorStack(glyphWithError, "Can't get glyph to measure");
+			width += (*glyphWithError)->advance;
+		}
+		return width;
+	}
+
+
+	auto GlyphCache::clear() noexcept -> void {
+		m_glyphs.clear();
+		m_shelves.clear();
+	}
+
+
+	auto GlyphCache::getStatistics() const noexcept -> GlyphCacheStatistics {
+		GlyphCacheStatistics statistics {m_statistics};
+		statistics.glyphCount = m_glyphs.size();
+		return statistics;
+	}
+
+
+	auto GlyphCache::getGlyph(const GlyphKey& key) noexcept -> lw::Failable<const Glyph*> {
+		if (const auto glyph {m_glyphs.find(key)}; glyph != m_glyphs.end()) {
+			++m_statistics.hitCount;
+			return &glyph->second;
+		}
+		++m_statistics.missCount;
+
+		const lw::trace::Scope traceScope {"GlyphCache::rasterize"};
+		lw::Failable bitmapWithError {m_rasterizer(key.font, key.size, key.codepoint)};
+		if (!bitmapWithError)
+			return lw::pushToErrorStack(bitmapWithError, "Can't rasterize glyph U+{:04X}",
+				static_cast<std::uint32_t> (key.codepoint)
+			);
+		const lw::GlyphBitmap& bitmap {*bitmapWithError};
+		if (bitmap.width > m_atlasWidth || bitmap.height > m_atlasHeight) {
+			return lw::makeErrorStack("Glyph of {}x{} doesn't fit in the {}x{} atlas",
+				bitmap.width, bitmap.height, m_atlasWidth, m_atlasHeight
+			);
+		}
+		const bool isEmpty {bitmap.width == 0 || bitmap.height == 0};
+		if (!isEmpty && (bitmap.stride < bitmap.width
+			|| bitmap.coverage.size() < static_cast<std::size_t> (bitmap.stride) * (bitmap.height - 1) + bitmap.width
+		))
+			return lw::makeErrorStack("Glyph coverage is smaller than its size");
+
+		Glyph glyph {
+			.atlasX = 0,
+			.atlasY = 0,
+			.width = bitmap.width,
+			.height = bitmap.height,
+			.bearingX = bitmap.bearingX,
+			.bearingY = bitmap.bearingY,
+			.advance = bitmap.advance
+		};
+		if (!isEmpty) {
+			std::optional position {this->allocate(bitmap.width, bitmap.height)};
+			if (!position) {
+				// glyphs still in use get rasterized again, which beats tracking their usage on every draw
+				this->clear();
+				++m_statistics.flushCount;
+				position = this->allocate(bitmap.width, bitmap.height);
+			}
+			glyph.atlasX = position->x;
+			glyph.atlasY = position->y;
+			for (std::uint32_t y {0}; y < bitmap.height; ++y) {
+				std::memcpy(
+					&m_atlas[static_cast<std::size_t> (glyph.atlasY + y) * m_atlasWidth + glyph.atlasX],
+					&bitmap.coverage[static_cast<std::size_t> (y) * bitmap.stride],
+					bitmap.width
+				);
+			}
+		}
+		return &m_glyphs.emplace(key, glyph).first->second;
+	}
+
+
+	auto GlyphCache::allocate(std::uint32_t width, std::uint32_t height) noexcept -> std::optional<AtlasPosition> {
+		Shelf* bestShelf {nullptr};
+		for (Shelf& shelf : m_shelves) {
+			if (shelf.height < height || m_atlasWidth - shelf.width < width)
+				continue;
+			if (bestShelf == nullptr || shelf.height < bestShelf->height)
+				bestShelf = &shelf;
+		}
+
+		// glyphs much smaller than their shelf would waste its height, so they get their own shelf while there's room
+		const std::uint32_t usedHeight {m_shelves.empty() ? 0 : m_shelves.back().y + m_shelves.back().height};
+		const bool canAddShelf {m_atlasHeight - usedHeight >= height};
+		const bool isWasteful {bestShelf != nullptr && bestShelf->height > height + height / 2};
+		if (canAddShelf && (bestShelf == nullptr || isWasteful))
+			bestShelf = &m_shelves.emplace_back(Shelf{.y = usedHeight, .height = height, .width = 0});
+		if (bestShelf == nullptr)
+			return std::nullopt;
+
+		const AtlasPosition position {.x = bestShelf->width, .y = bestShelf->y};
+		bestShelf->width += width;
+		return position;
+	}
+}
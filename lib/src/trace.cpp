@@ -0,0 +1,203 @@
+#include "liteway/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "liteway/error.hpp"
+#include "liteway/seqlock.hpp"
+
+#ifndef LW_TRACE_RING_CAPACITY
+	#define LW_TRACE_RING_CAPACITY 16384
+#endif
+
+
+namespace lw::trace {
+#if LW_TRACING_ENABLED
+	/// Set by the `LITEWAY_TRACE_RING_CAPACITY` CMake cache variable
+	static constexpr std::size_t ringCapacity {LW_TRACE_RING_CAPACITY};
+	static_assert(ringCapacity != 0uz && (ringCapacity & (ringCapacity - 1uz)) == 0uz,
+		"Ring capacity must be a power of two"
+	);
+	static constexpr std::size_t ringChunkSize {std::min(ringCapacity, 256uz)};
+	static constexpr std::size_t ringChunkCount {ringCapacity / ringChunkSize};
+
+	struct RingChunk {
+		std::array<lw::SeqLock<Event>, ringChunkSize> events;
+	};
+
+	/*
+	 * Single producer ring: only its thread writes to it. Each slot is a seqlock so the exporter never reads an event
+	 * while it is being written, and the exporter re-reads `head` after copying to throw away the slots that were
+	 * overwritten by newer events meanwhile. Chunks are allocated the first time the ring reaches them, so threads
+	 * that only trace a few events don't pay for the whole capacity
+	 */
+	struct Ring {
+		Ring() noexcept = default;
+		Ring(const Ring&) = delete;
+		auto operator=(const Ring&) = delete;
+		Ring(Ring&&) = delete;
+		auto operator=(Ring&&) = delete;
+		~Ring() {
+			for (auto& chunk : chunks)
+				// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+				delete chunk.load(std::memory_order_relaxed);
+		}
+
+		auto getSlot(std::uint64_t index) const noexcept -> lw::SeqLock<Event>& {
+			const std::size_t slot {index & (ringCapacity - 1uz)};
+			return chunks[slot / ringChunkSize].load(std::memory_order_acquire)->events[slot % ringChunkSize];
+		}
+
+		std::uint32_t threadId {0};
+		std::atomic<std::uint64_t> head {0};
+		std::array<std::atomic<RingChunk*>, ringChunkCount> chunks {};
+	};
+
+	struct RingRegistry {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Ring>> rings;
+	};
+
+	static auto getRingRegistry() noexcept -> RingRegistry& {
+		static RingRegistry registry {};
+		return registry;
+	}
+
+	static auto getThreadRing() noexcept -> Ring& {
+		// rings are kept by the registry after their thread exits so their events can still be exported
+		thread_local Ring* ring {[]() noexcept -> Ring* {
+			RingRegistry& registry {getRingRegistry()};
+			const std::scoped_lock lock {registry.mutex};
+			auto& newRing {registry.rings.emplace_back(std::make_unique<Ring> ())};
+			newRing->threadId = static_cast<std::uint32_t> (registry.rings.size());
+			return newRing.get();
+		} ()};
+		return *ring;
+	}
+
+	static auto printEscaped(std::FILE* file, std::string_view string) noexcept -> void {
+		// runs of characters that need no escaping are printed at once
+		std::size_t runStart {0};
+		for (std::size_t i {0}; i < string.size(); ++i) {
+			if (string[i] != '"' && string[i] != '\\')
+				continue;
+			std::print(file, "{}\\{}", string.substr(runStart, i - runStart), string[i]);
+			runStart = i + 1;
+		}
+		std::print(file, "{}", string.substr(runStart));
+	}
+
+	static auto printEvent(std::FILE* file, const Event& event, int processId, std::uint32_t threadId) noexcept
+		-> void
+	{
+		constexpr std::uint64_t nanosecondsPerMicrosecond {1000};
+		std::print(file, "{{\"name\":\"");
+		printEscaped(file, event.name);
+		std::print(file, "\",\"cat\":\"liteway\",\"pid\":{},\"tid\":{},\"ts\":{}.{:03}",
+			processId,
+			threadId,
+			event.timestamp / nanosecondsPerMicrosecond,
+			event.timestamp % nanosecondsPerMicrosecond
+		);
+		switch (event.type) {
+			case EventType::scope:
+				std::print(file, ",\"ph\":\"X\",\"dur\":{}.{:03}}}",
+					static_cast<std::uint64_t> (event.value) / nanosecondsPerMicrosecond,
+					static_cast<std::uint64_t> (event.value) % nanosecondsPerMicrosecond
+				);
+				break;
+			case EventType::counter:
+				std::print(file, ",\"ph\":\"C\",\"args\":{{\"value\":{}}}}}", event.value);
+				break;
+			case EventType::instant:
+				std::print(file, ",\"ph\":\"i\",\"s\":\"t\"}}");
+				break;
+		}
+	}
+
+
+	auto now() noexcept -> std::uint64_t {
+		return static_cast<std::uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count());
+	}
+
+
+	auto record(const Event& event) noexcept -> void {
+		Ring& ring {getThreadRing()};
+		const std::uint64_t head {ring.head.load(std::memory_order_relaxed)};
+		// only this thread allocates its chunks, the release of `head` below publishes a new one with the event
+		std::atomic<RingChunk*>& chunk {ring.chunks[(head & (ringCapacity - 1uz)) / ringChunkSize]};
+		if (chunk.load(std::memory_order_relaxed) == nullptr)
+			// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+			chunk.store(new RingChunk{}, std::memory_order_release);
+		ring.getSlot(head).store(event);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+
+	auto exportChromeJson(std::FILE* file) noexcept -> lw::Failable<void> {
+		const int processId {getpid()};
+		std::vector<Event> snapshot {};
+		snapshot.reserve(ringCapacity);
+		bool isFirstEvent {true};
+
+		std::print(file, "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+		RingRegistry& registry {getRingRegistry()};
+		const std::scoped_lock lock {registry.mutex};
+		for (const auto& ring : registry.rings) {
+			const std::uint64_t head {ring->head.load(std::memory_order_acquire)};
+			const std::uint64_t begin {head > ringCapacity ? head - ringCapacity : 0};
+			snapshot.clear();
+			for (std::uint64_t i {begin}; i < head; ++i)
+				snapshot.push_back(ring->getSlot(i).load());
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const std::uint64_t newHead {ring->head.load(std::memory_order_relaxed)};
+			const std::uint64_t overwrittenEnd {newHead > ringCapacity ? newHead - ringCapacity : 0};
+			const std::uint64_t validBegin {std::max(begin, overwrittenEnd)};
+
+			for (std::uint64_t i {validBegin}; i < head; ++i) {
+				if (!isFirstEvent)
+					std::print(file, ",");
+				isFirstEvent = false;
+				std::print(file, "\n");
+				printEvent(file, snapshot[i - begin], processId, ring->threadId);
+			}
+		}
+		std::println(file, "\n]}}");
+
+		if (std::ferror(file) != 0)
+			return lw::makeErrorStack("Can't write chrome trace");
+		return {};
+	}
+
+#else
+	auto now() noexcept -> std::uint64_t {
+		return 0;
+	}
+
+
+	auto record([[maybe_unused]] const Event& event) noexcept -> void {}
+
+
+	auto exportChromeJson(std::FILE* file) noexcept -> lw::Failable<void> {
+		std::println(file, "{{\"traceEvents\":[]}}");
+		if (std::ferror(file) != 0)
+			return lw::makeErrorStack("Can't write chrome trace");
+		return {};
+	}
+#endif
+}
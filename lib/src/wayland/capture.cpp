@@ -0,0 +1,374 @@
+#include "liteway/wayland/capture.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "liteway/error.hpp"
+#include "liteway/trace.hpp"
+#include "liteway/wayland/window.hpp"
+
+
+namespace lw::wayland::internals {
+	/// Frames in flight are bounded by the swapchains, this is plenty
+	static constexpr std::uint32_t ringEntryCount {16};
+	/// Consecutive failed waits after which `close` gives up on the pending writes
+	static constexpr std::uint32_t maxWaitFailureCount {8};
+
+	static auto ioUringSetup(std::uint32_t entryCount, io_uring_params& params) noexcept -> int {
+		return static_cast<int> (syscall(__NR_io_uring_setup, entryCount, &params));
+	}
+
+	static auto ioUringEnter(int fd, std::uint32_t submitCount, std::uint32_t minCompleteCount, std::uint32_t flags)
+		noexcept -> int
+	{
+		int result {};
+		while ((result = static_cast<int> (syscall(
+			__NR_io_uring_enter, fd, submitCount, minCompleteCount, flags, nullptr, 0
+		))) < 0 && errno == EINTR);
+		return result;
+	}
+
+	template <typename T>
+	static auto getRingField(std::span<std::byte> ring, std::uint32_t offset) noexcept -> T* {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return reinterpret_cast<T*> (ring.data() + offset);
+	}
+
+
+	auto FrameWriterDeleter::operator()(FrameWriter* frameWriter) const noexcept -> void {
+		// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+		delete frameWriter;
+	}
+
+
+	auto FrameWriter::open(std::string_view path) noexcept -> lw::Failable<void> {
+		if (this->isOpen())
+			return lw::makeErrorStack("Frame writer is already writing to a file");
+		const std::string pathString {path};
+		m_file = ::open(pathString.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (m_file < 0)
+			return lw::makeErrorStack("Can't open capture file '{}' : {}", path, strerror(errno));
+		m_offset = 0;
+		m_writeError = 0;
+
+		if (this->setupIoUring())
+			return {};
+		// io_uring may be missing, too old, or forbidden by seccomp or `kernel.io_uring_disabled`
+		this->destroyIoUring();
+		m_thread = std::jthread{[this](std::stop_token stopToken) noexcept {
+			this->runWriterThread(std::move(stopToken));
+		}};
+		return {};
+	}
+
+
+	auto FrameWriter::close() noexcept -> lw::Failable<void> {
+		if (!this->isOpen())
+			return {};
+		std::vector<void*> droppedTokens {};
+		std::uint32_t waitFailureCount {0};
+		while (m_pendingWriteCount != 0 && waitFailureCount < maxWaitFailureCount) {
+			if (!this->waitForCompletion()) {
+				++waitFailureCount;
+				std::this_thread::yield();
+				continue;
+			}
+			waitFailureCount = 0;
+			// only fails on the sticky write error, which is returned below
+			static_cast<void> (this->collectCompleted(droppedTokens));
+			droppedTokens.clear();
+		}
+
+		/*
+		 * The ring can't be waited on anymore, so the pending writes are cancelled and closing the ring cancels the
+		 * rest. A write the kernel is already running may still read the frames after their memory is unmapped, it then
+		 * fails with EFAULT and at worst garbles the end of a capture that is reported as failed anyway
+		 */
+		const std::size_t abandonedWriteCount {std::exchange(m_pendingWriteCount, 0)};
+		if (abandonedWriteCount != 0 && m_ring.fd >= 0)
+			this->cancelIoUring();
+
+		if (m_thread.joinable()) {
+			m_thread.request_stop();
+			m_thread.join();
+		}
+		this->destroyIoUring();
+		const int writeError {std::exchange(m_writeError, 0)};
+		if (::close(std::exchange(m_file, -1)) != 0)
+			return lw::makeErrorStack("Can't close capture file : {}", strerror(errno));
+		if (abandonedWriteCount != 0)
+			return lw::makeErrorStack("Gave up waiting for {} pending frame writes", abandonedWriteCount);
+		if (writeError != 0)
+			return lw::makeErrorStack("Can't write frame to capture file : {}", strerror(writeError));
+		return {};
+	}
+
+
+	auto FrameWriter::write(std::span<const std::byte> data, void* token) noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"FrameWriter::write"};
+		if (!this->isOpen())
+			return lw::makeErrorStack("Frame writer has no file to write to");
+		const Request request {.data = data, .offset = m_offset, .token = token};
+		m_offset += data.size();
+		++m_pendingWriteCount;
+
+		if (m_ring.fd < 0) {
+			const std::scoped_lock lock {m_mutex};
+			m_threadRequests.push_back(request);
+			m_condition.notify_all();
+			return {};
+		}
+
+		while (m_ringRequests.size() >= m_ring.completionEntryCount) {
+			if (ioUringEnter(m_ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0)
+				return lw::makeErrorStack("Can't wait for io_uring completions : {}", strerror(errno));
+			lw::Failable reapResult {this->reapIoUring()};
+			if (!reapResult)
+				return lw::pushToErrorStack(reapResult, "Can't reap io_uring completions");
+		}
+		auto& ringRequest {*m_ringRequests.emplace_back(std::make_unique<Request> (request))};
+		lw::Failable submitResult {this->submitToIoUring(ringRequest)};
+		if (!submitResult) {
+			m_ringRequests.pop_back();
+			--m_pendingWriteCount;
+			return lw::pushToErrorStack(submitResult, "Can't submit frame write");
+		}
+		return {};
+	}
+
+
+	auto FrameWriter::collectCompleted(std::vector<void*>& tokens) noexcept -> lw::Failable<void> {
+		if (m_ring.fd >= 0) {
+			lw::Failable reapResult {this->reapIoUring()};
+			if (!reapResult)
+				return lw::pushToErrorStack(reapResult, "Can't reap io_uring completions");
+		}
+
+		const std::scoped_lock lock {m_mutex};
+		m_pendingWriteCount -= m_completed.size();
+		tokens.insert(tokens.end(), m_completed.begin(), m_completed.end());
+		m_completed.clear();
+		if (m_writeError != 0)
+			return lw::makeErrorStack("Can't write frame to capture file : {}", strerror(m_writeError));
+		return {};
+	}
+
+
+	auto FrameWriter::waitForCompletion() noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"FrameWriter::waitForCompletion"};
+		if (m_ring.fd < 0) {
+			std::unique_lock lock {m_mutex};
+			m_condition.wait(lock, [this]() noexcept {
+				return !m_completed.empty() || m_pendingWriteCount == 0;
+			});
+			return {};
+		}
+
+		while (m_completed.empty() && !m_ringRequests.empty()) {
+			if (ioUringEnter(m_ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0)
+				return lw::makeErrorStack("Can't wait for io_uring completions : {}", strerror(errno));
+			lw::Failable reapResult {this->reapIoUring()};
+			if (!reapResult)
+				return lw::pushToErrorStack(reapResult, "Can't reap io_uring completions");
+		}
+		return {};
+	}
+
+
+	auto FrameWriter::setupIoUring() noexcept -> lw::Failable<void> {
+		io_uring_params params {};
+		m_ring.fd = ioUringSetup(ringEntryCount, params);
+		if (m_ring.fd < 0)
+			return lw::makeErrorStack("Can't setup io_uring : {}", strerror(errno));
+		// `IORING_OP_WRITE` came with the same kernel as this feature, 5.6
+		if ((params.features & IORING_FEAT_RW_CUR_POS) == 0)
+			return lw::makeErrorStack("Kernel's io_uring doesn't support IORING_OP_WRITE");
+
+		std::size_t submissionRingSize {params.sq_off.array + params.sq_entries * sizeof(std::uint32_t)};
+		std::size_t completionRingSize {params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe)};
+		const bool isSingleMapping {(params.features & IORING_FEAT_SINGLE_MMAP) != 0};
+		if (isSingleMapping) {
+			submissionRingSize = std::max(submissionRingSize, completionRingSize);
+			completionRingSize = submissionRingSize;
+		}
+
+		void* submissionRing {mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			m_ring.fd, IORING_OFF_SQ_RING
+		)};
+		if (submissionRing == MAP_FAILED)
+			return lw::makeErrorStack("Can't map io_uring submission ring : {}", strerror(errno));
+		m_ring.submissionRing = {static_cast<std::byte*> (submissionRing), submissionRingSize};
+
+		void* completionRing {submissionRing};
+		if (!isSingleMapping) {
+			completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				m_ring.fd, IORING_OFF_CQ_RING
+			);
+			if (completionRing == MAP_FAILED)
+				return lw::makeErrorStack("Can't map io_uring completion ring : {}", strerror(errno));
+		}
+		m_ring.completionRing = {static_cast<std::byte*> (completionRing), completionRingSize};
+
+		void* submissionEntries {mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, m_ring.fd, IORING_OFF_SQES
+		)};
+		if (submissionEntries == MAP_FAILED)
+			return lw::makeErrorStack("Can't map io_uring submission entries : {}", strerror(errno));
+		m_ring.submissionEntries = {static_cast<io_uring_sqe*> (submissionEntries), params.sq_entries};
+
+		m_ring.submissionTail = getRingField<std::uint32_t> (m_ring.submissionRing, params.sq_off.tail);
+		m_ring.submissionArray = getRingField<std::uint32_t> (m_ring.submissionRing, params.sq_off.array);
+		m_ring.submissionMask = *getRingField<std::uint32_t> (m_ring.submissionRing, params.sq_off.ring_mask);
+		m_ring.completionHead = getRingField<std::uint32_t> (m_ring.completionRing, params.cq_off.head);
+		m_ring.completionTail = getRingField<std::uint32_t> (m_ring.completionRing, params.cq_off.tail);
+		m_ring.completionMask = *getRingField<std::uint32_t> (m_ring.completionRing, params.cq_off.ring_mask);
+		m_ring.completionEntryCount = params.cq_entries;
+		m_ring.completions = getRingField<io_uring_cqe> (m_ring.completionRing, params.cq_off.cqes);
+		return {};
+	}
+
+
+	auto FrameWriter::destroyIoUring() noexcept -> void {
+		if (!m_ring.submissionEntries.empty())
+			munmap(m_ring.submissionEntries.data(), m_ring.submissionEntries.size_bytes());
+		if (!m_ring.completionRing.empty() && m_ring.completionRing.data() != m_ring.submissionRing.data())
+			munmap(m_ring.completionRing.data(), m_ring.completionRing.size());
+		if (!m_ring.submissionRing.empty())
+			munmap(m_ring.submissionRing.data(), m_ring.submissionRing.size());
+		if (m_ring.fd >= 0)
+			::close(m_ring.fd);
+		m_ring = {};
+		m_ringRequests.clear();
+	}
+
+
+	auto FrameWriter::submitToIoUring(Request& request) noexcept -> lw::Failable<void> {
+		// the kernel consumes the entry during `io_uring_enter` as there is no polling thread, so the ring never fills
+		const std::uint32_t tail {*m_ring.submissionTail};
+		const std::uint32_t index {tail & m_ring.submissionMask};
+		m_ring.submissionEntries[index] = io_uring_sqe{};
+		io_uring_sqe& entry {m_ring.submissionEntries[index]};
+		entry.opcode = IORING_OP_WRITE;
+		entry.fd = m_file;
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		entry.addr = reinterpret_cast<std::uint64_t> (request.data.data());
+		entry.user_data = reinterpret_cast<std::uint64_t> (&request);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		entry.len = static_cast<std::uint32_t> (request.data.size());
+		entry.off = request.offset;
+		m_ring.submissionArray[index] = index;
+		std::atomic_ref{*m_ring.submissionTail}.store(tail + 1, std::memory_order_release);
+
+		if (ioUringEnter(m_ring.fd, 1, 0, 0) != 1) {
+			std::atomic_ref{*m_ring.submissionTail}.store(tail, std::memory_order_release);
+			return lw::makeErrorStack("Can't submit write to io_uring : {}", strerror(errno));
+		}
+		return {};
+	}
+
+
+	auto FrameWriter::cancelIoUring() noexcept -> void {
+		// completions are never reaped afterwards, their null user data would otherwise be taken for a request
+		for (const auto& request : m_ringRequests) {
+			const std::uint32_t tail {*m_ring.submissionTail};
+			const std::uint32_t index {tail & m_ring.submissionMask};
+			m_ring.submissionEntries[index] = io_uring_sqe{};
+			io_uring_sqe& entry {m_ring.submissionEntries[index]};
+			entry.opcode = IORING_OP_ASYNC_CANCEL;
+			entry.fd = -1;
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			entry.addr = reinterpret_cast<std::uint64_t> (request.get());
+			m_ring.submissionArray[index] = index;
+			std::atomic_ref{*m_ring.submissionTail}.store(tail + 1, std::memory_order_release);
+			if (ioUringEnter(m_ring.fd, 1, 0, 0) != 1) {
+				std::atomic_ref{*m_ring.submissionTail}.store(tail, std::memory_order_release);
+				return;
+			}
+		}
+	}
+
+
+	auto FrameWriter::reapIoUring() noexcept -> lw::Failable<void> {
+		std::uint32_t head {*m_ring.completionHead};
+		const std::uint32_t tail {std::atomic_ref{*m_ring.completionTail}.load(std::memory_order_acquire)};
+		for (; head != tail; ++head) {
+			const io_uring_cqe& completion {m_ring.completions[head & m_ring.completionMask]};
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+			auto& request {*reinterpret_cast<Request*> (completion.user_data)};
+			const auto writtenSize {static_cast<std::size_t> (std::max(completion.res, 0))};
+
+			int writeError {0};
+			if (completion.res < 0)
+				writeError = -completion.res;
+			else if (writtenSize == 0 && !request.data.empty())
+				writeError = EIO;
+			else if (writtenSize < request.data.size()) {
+				request.data = request.data.subspan(writtenSize);
+				request.offset += writtenSize;
+				lw::Failable submitResult {this->submitToIoUring(request)};
+				if (submitResult)
+					continue;
+				writeError = errno;
+			}
+			if (writeError != 0 && m_writeError == 0)
+				m_writeError = writeError;
+
+			m_completed.push_back(request.token);
+			std::erase_if(m_ringRequests, [&request](const auto& ringRequest) noexcept {
+				return ringRequest.get() == &request;
+			});
+		}
+		std::atomic_ref{*m_ring.completionHead}.store(head, std::memory_order_release);
+		return {};
+	}
+
+
+	auto FrameWriter::runWriterThread(std::stop_token stopToken) noexcept -> void {
+		std::unique_lock lock {m_mutex};
+		while (m_condition.wait(lock, stopToken, [this]() noexcept {return !m_threadRequests.empty();})) {
+			Request request {m_threadRequests.front()};
+			m_threadRequests.pop_front();
+			lock.unlock();
+
+			int writeError {0};
+			while (!request.data.empty()) {
+				const ssize_t writtenSize {pwrite(m_file, request.data.data(), request.data.size(),
+					static_cast<off_t> (request.offset)
+				)};
+				if (writtenSize < 0 && errno == EINTR)
+					continue;
+				if (writtenSize <= 0) {
+					writeError = writtenSize < 0 ? errno : EIO;
+					break;
+				}
+				request.data = request.data.subspan(static_cast<std::size_t> (writtenSize));
+				request.offset += static_cast<std::uint64_t> (writtenSize);
+			}
+
+			lock.lock();
+			if (writeError != 0 && m_writeError == 0)
+				m_writeError = writeError;
+			m_completed.push_back(request.token);
+			m_condition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,619 @@
+#include "liteway/wayland/clipboard.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include <wayland-client-protocol.h>
+#include <wayland-client.h>
+
+#include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/trace.hpp"
+#include "liteway/wayland/instance.hpp"
+#include "liteway/wayland/window.hpp"
+
+
+namespace lw::wayland {
+	static const wl_data_device_listener dataDeviceListener {
+		.data_offer = &Instance::handleDataDeviceDataOffer,
+		.enter = &Instance::handleDataDeviceEnter,
+		.leave = &Instance::handleDataDeviceLeave,
+		.motion = &Instance::handleDataDeviceMotion,
+		.drop = &Instance::handleDataDeviceDrop,
+		.selection = &Instance::handleDataDeviceSelection
+	};
+
+	static const wl_data_offer_listener dataOfferListener {
+		.offer = &Instance::handleDataOfferOffer,
+		.source_actions = [](void*, wl_data_offer*, std::uint32_t) noexcept -> void {},
+		.action = [](void*, wl_data_offer*, std::uint32_t) noexcept -> void {}
+	};
+
+	static const wl_data_source_listener dataSourceListener {
+		.target = [](void*, wl_data_source*, const char*) noexcept -> void {},
+		.send = &Instance::handleDataSourceSend,
+		.cancelled = &Instance::handleDataSourceCancelled,
+		.dnd_drop_performed = [](void*, wl_data_source*) noexcept -> void {},
+		// once the drop is over the source is as useless as a cancelled one
+		.dnd_finished = &Instance::handleDataSourceCancelled,
+		.action = [](void*, wl_data_source*, std::uint32_t) noexcept -> void {}
+	};
+
+
+	/// Pipes we create are grown to this size, so each splice moves more data
+	static constexpr int transferPipeSize {1 << 20};
+	static constexpr std::size_t transferChunkSize {1uz << 20uz};
+	/// Keeps a huge transfer from stalling the event loop, the rest is moved by the next updates
+	static constexpr std::size_t maxTransferSizePerUpdate {8uz << 20uz};
+	/// Used when the fds don't support `splice` or `sendfile`, so it lives on the stack
+	static constexpr std::size_t fallbackChunkSize {1uz << 16uz};
+
+	/*
+	 * Writing to a pipe whose reader is gone raises SIGPIPE, which kills applications that don't ignore it. The
+	 * signal is blocked meanwhile and then consumed, the write already reported EPIPE
+	 */
+	template <typename Function>
+	static auto callWithoutSigpipe(Function&& function) noexcept -> decltype(function()) {
+		sigset_t sigpipeSet {};
+		sigemptyset(&sigpipeSet);
+		sigaddset(&sigpipeSet, SIGPIPE);
+		sigset_t pendingSet {};
+		sigpending(&pendingSet);
+		const bool wasPending {sigismember(&pendingSet, SIGPIPE) == 1};
+		sigset_t previousMask {};
+		pthread_sigmask(SIG_BLOCK, &sigpipeSet, &previousMask);
+
+		auto result {function()};
+
+		if (!wasPending) {
+			const timespec noWait {};
+			while (sigtimedwait(&sigpipeSet, nullptr, &noWait) < 0 && errno == EINTR);
+		}
+		pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+		return result;
+	}
+
+	/// Returns whether the transfer is over
+	static auto receiveTransferWithCopy(internals::Transfer& transfer) noexcept -> lw::Failable<bool> {
+		std::array<std::byte, fallbackChunkSize> chunk;
+		for (std::size_t movedSize {0}; movedSize < maxTransferSizePerUpdate;) {
+			const ssize_t readSize {read(transfer.pipe, chunk.data(), chunk.size())};
+			if (readSize == 0)
+				return true;
+			if (readSize < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN)
+					return false;
+				return lw::makeErrorStack("Can't read from transfer pipe : {}", strerror(errno));
+			}
+
+			for (std::size_t writtenSize {0}; writtenSize < static_cast<std::size_t> (readSize);) {
+				const ssize_t result {write(transfer.file, chunk.data() + writtenSize,
+					static_cast<std::size_t> (readSize) - writtenSize
+				)};
+				if (result < 0 && errno == EINTR)
+					continue;
+				if (result <= 0)
+					return lw::makeErrorStack("Can't write received data : {}", strerror(errno));
+				writtenSize += static_cast<std::size_t> (result);
+			}
+			transfer.size += static_cast<std::uint64_t> (readSize);
+			movedSize += static_cast<std::size_t> (readSize);
+		}
+		return false;
+	}
+
+	static auto receiveTransfer(internals::Transfer& transfer) noexcept -> lw::Failable<bool> {
+		for (std::size_t movedSize {0}; movedSize < maxTransferSizePerUpdate;) {
+			const ssize_t splicedSize {splice(transfer.pipe, nullptr, transfer.file, nullptr, transferChunkSize,
+				SPLICE_F_MOVE | SPLICE_F_NONBLOCK
+			)};
+			if (splicedSize == 0)
+				return true;
+			if (splicedSize > 0) {
+				transfer.size += static_cast<std::uint64_t> (splicedSize);
+				movedSize += static_cast<std::size_t> (splicedSize);
+				continue;
+			}
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				return false;
+			// e.g. files opened with `O_APPEND`
+			if (errno == EINVAL)
+				return receiveTransferWithCopy(transfer);
+			return lw::makeErrorStack("Can't splice transfer pipe : {}", strerror(errno));
+		}
+		return false;
+	}
+
+	static auto sendTransferWithCopy(internals::Transfer& transfer) noexcept -> lw::Failable<bool> {
+		std::array<std::byte, fallbackChunkSize> chunk;
+		for (std::size_t movedSize {0}; movedSize < maxTransferSizePerUpdate;) {
+			const ssize_t readSize {pread(transfer.file, chunk.data(), chunk.size(),
+				static_cast<off_t> (transfer.size)
+			)};
+			if (readSize == 0)
+				return true;
+			if (readSize < 0) {
+				if (errno == EINTR)
+					continue;
+				return lw::makeErrorStack("Can't read sent data : {}", strerror(errno));
+			}
+
+			// a partial write is fine, the next read starts right after what was written
+			const ssize_t writtenSize {write(transfer.pipe, chunk.data(), static_cast<std::size_t> (readSize))};
+			if (writtenSize < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN)
+					return false;
+				return lw::makeErrorStack("Can't write to transfer pipe : {}", strerror(errno));
+			}
+			transfer.size += static_cast<std::uint64_t> (writtenSize);
+			movedSize += static_cast<std::size_t> (writtenSize);
+		}
+		return false;
+	}
+
+	static auto sendTransfer(internals::Transfer& transfer) noexcept -> lw::Failable<bool> {
+		for (std::size_t movedSize {0}; movedSize < maxTransferSizePerUpdate;) {
+			auto offset {static_cast<off_t> (transfer.size)};
+			const ssize_t sentSize {sendfile(transfer.pipe, transfer.file, &offset, transferChunkSize)};
+			if (sentSize == 0)
+				return true;
+			if (sentSize > 0) {
+				transfer.size += static_cast<std::uint64_t> (sentSize);
+				movedSize += static_cast<std::size_t> (sentSize);
+				continue;
+			}
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				return false;
+			// the fd can't be mapped, e.g. it is itself a pipe
+			if (errno == EINVAL || errno == ENOSYS)
+				return sendTransferWithCopy(transfer);
+			return lw::makeErrorStack("Can't send file to transfer pipe : {}", strerror(errno));
+		}
+		return false;
+	}
+
+
+	auto Instance::setClipboard(std::span<const DataContent> contents) noexcept -> lw::Failable<void> {
+		if (m_state->dataDevice == nullptr)
+			return lw::makeErrorStack("Compositor doesn't support data devices");
+		if (contents.empty()) {
+			wl_data_device_set_selection(m_state->dataDevice, nullptr, m_state->inputSerial);
+			m_state->clipboardSource.reset();
+			return {};
+		}
+
+		lw::Failable sourceWithError {Instance::s_createDataSource(*m_state, contents)};
+		if (!sourceWithError)
+			return lw::pushToErrorStack(sourceWithError, "Can't create clipboard data source");
+		wl_data_device_set_selection(m_state->dataDevice, (*sourceWithError)->source, m_state->inputSerial);
+		m_state->clipboardSource = std::move(*sourceWithError);
+		return {};
+	}
+
+
+	auto Instance::startDrag(const Window& window, std::span<const DataContent> contents) noexcept
+		-> lw::Failable<void>
+	{
+		if (m_state->dataDevice == nullptr)
+			return lw::makeErrorStack("Compositor doesn't support data devices");
+		lw::Failable sourceWithError {Instance::s_createDataSource(*m_state, contents)};
+		if (!sourceWithError)
+			return lw::pushToErrorStack(sourceWithError, "Can't create drag data source");
+		wl_data_source* source {(*sourceWithError)->source};
+		if (wl_data_source_get_version(source) >= WL_DATA_SOURCE_SET_ACTIONS_SINCE_VERSION)
+			wl_data_source_set_actions(source, WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY);
+		wl_data_device_start_drag(m_state->dataDevice, source, window.m_surface, nullptr,
+			m_state->pointerButtonSerial
+		);
+		m_state->dragSource = std::move(*sourceWithError);
+		return {};
+	}
+
+
+	auto Instance::receiveClipboard(std::string_view mimeType, int fd) noexcept -> lw::Failable<lw::TransferId> {
+		if (m_state->clipboardOffer == nullptr)
+			return lw::makeErrorStack("Clipboard is empty");
+		if (!std::ranges::contains(m_state->clipboardOffer->mimeTypes, mimeType))
+			return lw::makeErrorStack("Clipboard isn't offered as '{}'", mimeType);
+		lw::Failable transferWithError {Instance::s_startReceive(
+			*m_state,
+			m_state->clipboardOffer->offer,
+			mimeType,
+			fd
+		)};
+		if (!transferWithError)
+			return lw::pushToErrorStack(transferWithError, "Can't receive clipboard as '{}'", mimeType);
+		return (*transferWithError)->id;
+	}
+
+
+	auto Instance::acceptDrag(std::optional<std::string_view> mimeType) noexcept -> lw::Failable<void> {
+		if (m_state->dragOffer == nullptr)
+			return lw::makeErrorStack("Nothing is being dragged over a window");
+		wl_data_offer* offer {m_state->dragOffer->offer};
+		if (mimeType && !std::ranges::contains(m_state->dragOffer->mimeTypes, *mimeType))
+			return lw::makeErrorStack("Dragged data isn't offered as '{}'", *mimeType);
+
+		const std::optional<std::string> mimeTypeString {mimeType.transform([](std::string_view type) noexcept {
+			return std::string{type};
+		})};
+		wl_data_offer_accept(offer, m_state->dragEnterSerial, mimeTypeString ? mimeTypeString->c_str() : nullptr);
+		if (wl_data_offer_get_version(offer) >= WL_DATA_OFFER_SET_ACTIONS_SINCE_VERSION) {
+			const std::uint32_t action {mimeType
+				? WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY
+				: WL_DATA_DEVICE_MANAGER_DND_ACTION_NONE
+			};
+			wl_data_offer_set_actions(offer, action, action);
+		}
+		return {};
+	}
+
+
+	auto Instance::receiveDrop(std::string_view mimeType, int fd) noexcept -> lw::Failable<lw::TransferId> {
+		if (m_state->droppedOffer == nullptr)
+			return lw::makeErrorStack("Nothing was dropped");
+		if (!std::ranges::contains(m_state->droppedOffer->mimeTypes, mimeType))
+			return lw::makeErrorStack("Dropped data isn't offered as '{}'", mimeType);
+		lw::Failable transferWithError {Instance::s_startReceive(
+			*m_state,
+			m_state->droppedOffer->offer,
+			mimeType,
+			fd
+		)};
+		if (!transferWithError)
+			return lw::pushToErrorStack(transferWithError, "Can't receive dropped data as '{}'", mimeType);
+		(*transferWithError)->dropOffer = std::move(m_state->droppedOffer);
+		return (*transferWithError)->id;
+	}
+
+
+	auto Instance::handleDataDeviceDataOffer(
+		void* data,
+		[[maybe_unused]] wl_data_device* dataDevice,
+		wl_data_offer* dataOffer
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.pendingDataOffer = std::make_unique<internals::DataOffer> (dataOffer);
+		if (wl_data_offer_add_listener(dataOffer, &dataOfferListener, state.pendingDataOffer.get()) != 0)
+			state.pendingDataOffer.reset();
+	}
+
+
+	auto Instance::handleDataDeviceEnter(
+		void* data,
+		[[maybe_unused]] wl_data_device* dataDevice,
+		std::uint32_t serial,
+		wl_surface* surface,
+		wl_fixed_t x,
+		wl_fixed_t y,
+		wl_data_offer* dataOffer
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.dragOffer = Instance::s_takeDataOffer(state, dataOffer);
+		state.dragFocus = surface;
+		state.dragEnterSerial = serial;
+		state.dragX = wl_fixed_to_double(x);
+		state.dragY = wl_fixed_to_double(y);
+		state.events.emplace_back(lw::DragEvent{
+			.window = internals::getWindowId(surface),
+			.state = lw::DragState::entered,
+			.x = state.dragX,
+			.y = state.dragY,
+			.mimeTypes = state.dragOffer == nullptr ? std::vector<std::string>{} : state.dragOffer->mimeTypes
+		});
+	}
+
+
+	auto Instance::handleDataDeviceLeave(void* data, [[maybe_unused]] wl_data_device* dataDevice) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		// a drop is already the end of the drag
+		if (state.dragFocus != nullptr) {
+			state.events.emplace_back(lw::DragEvent{
+				.window = internals::getWindowId(state.dragFocus),
+				.state = lw::DragState::left,
+				.x = state.dragX,
+				.y = state.dragY,
+				.mimeTypes = {}
+			});
+		}
+		state.dragOffer.reset();
+		state.dragFocus = nullptr;
+	}
+
+
+	auto Instance::handleDataDeviceMotion(
+		void* data,
+		[[maybe_unused]] wl_data_device* dataDevice,
+		[[maybe_unused]] std::uint32_t time,
+		wl_fixed_t x,
+		wl_fixed_t y
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.dragX = wl_fixed_to_double(x);
+		state.dragY = wl_fixed_to_double(y);
+		state.events.emplace_back(lw::DragEvent{
+			.window = internals::getWindowId(state.dragFocus),
+			.state = lw::DragState::moved,
+			.x = state.dragX,
+			.y = state.dragY,
+			.mimeTypes = {}
+		});
+	}
+
+
+	auto Instance::handleDataDeviceDrop(void* data, [[maybe_unused]] wl_data_device* dataDevice) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.droppedOffer = std::move(state.dragOffer);
+		state.events.emplace_back(lw::DragEvent{
+			.window = internals::getWindowId(state.dragFocus),
+			.state = lw::DragState::dropped,
+			.x = state.dragX,
+			.y = state.dragY,
+			.mimeTypes = {}
+		});
+		state.dragFocus = nullptr;
+	}
+
+
+	auto Instance::handleDataDeviceSelection(
+		void* data,
+		[[maybe_unused]] wl_data_device* dataDevice,
+		wl_data_offer* dataOffer
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.clipboardOffer = Instance::s_takeDataOffer(state, dataOffer);
+		state.events.emplace_back(lw::ClipboardEvent{
+			.mimeTypes = state.clipboardOffer == nullptr ? std::vector<std::string>{} : state.clipboardOffer->mimeTypes
+		});
+	}
+
+
+	auto Instance::handleDataOfferOffer(
+		void* data,
+		[[maybe_unused]] wl_data_offer* dataOffer,
+		const char* mimeType
+	) noexcept -> void {
+		static_cast<internals::DataOffer*> (data)->mimeTypes.emplace_back(mimeType);
+	}
+
+
+	auto Instance::handleDataSourceSend(
+		void* data,
+		[[maybe_unused]] wl_data_source* dataSource,
+		const char* mimeType,
+		std::int32_t fd
+	) noexcept -> void {
+		auto& source {*static_cast<internals::DataSource*> (data)};
+		const auto content {std::ranges::find(source.contents, std::string_view{mimeType},
+			&internals::DataSourceContent::mimeType
+		)};
+		if (content == source.contents.end()) {
+			close(fd);
+			return;
+		}
+		// the pipe is closed when the send can't even start, so the receiving client just gets no data
+		(void)Instance::s_startSend(source.instance, content->fd, fd);
+	}
+
+
+	auto Instance::handleDataSourceCancelled(void* data, [[maybe_unused]] wl_data_source* dataSource) noexcept
+		-> void
+	{
+		auto* source {static_cast<internals::DataSource*> (data)};
+		internals::InstanceState& state {source->instance};
+		if (state.clipboardSource.get() == source)
+			state.clipboardSource.reset();
+		else if (state.dragSource.get() == source)
+			state.dragSource.reset();
+	}
+
+
+	auto Instance::s_createDataDevice(internals::InstanceState& state) noexcept -> lw::Failable<void> {
+		if (state.dataDeviceManager == nullptr)
+			return {};
+		state.dataDevice = lw::Owned{wl_data_device_manager_get_data_device(state.dataDeviceManager, state.seat)};
+		if (state.dataDevice == nullptr)
+			return lw::makeErrorStack("Can't get data device of seat");
+		if (wl_data_device_add_listener(state.dataDevice, &dataDeviceListener, &state) != 0)
+			return lw::makeErrorStack("Can't add listener to data device");
+		return {};
+	}
+
+
+	auto Instance::s_destroyDataDevice(internals::InstanceState& state) noexcept -> void {
+		for (internals::Transfer& transfer : state.transfers)
+			Instance::s_closeTransfer(transfer);
+		state.transfers.clear();
+		state.clipboardSource.reset();
+		state.dragSource.reset();
+		state.pendingDataOffer.reset();
+		state.clipboardOffer.reset();
+		state.dragOffer.reset();
+		state.droppedOffer.reset();
+		if (state.dataDevice != nullptr) {
+			if (wl_data_device_get_version(state.dataDevice) >= WL_DATA_DEVICE_RELEASE_SINCE_VERSION)
+				wl_data_device_release(state.dataDevice.release());
+			else
+				wl_data_device_destroy(state.dataDevice.release());
+		}
+		if (state.dataDeviceManager != nullptr)
+			wl_data_device_manager_destroy(state.dataDeviceManager.release());
+	}
+
+
+	auto Instance::s_takeDataOffer(internals::InstanceState& state, wl_data_offer* dataOffer) noexcept
+		-> std::unique_ptr<internals::DataOffer>
+	{
+		if (dataOffer == nullptr || state.pendingDataOffer == nullptr || state.pendingDataOffer->offer.get() != dataOffer)
+			return nullptr;
+		return std::move(state.pendingDataOffer);
+	}
+
+
+	auto Instance::s_createDataSource(
+		internals::InstanceState& state,
+		std::span<const DataContent> contents
+	) noexcept -> lw::Failable<std::unique_ptr<internals::DataSource>> {
+		auto source {std::make_unique<internals::DataSource> (state)};
+		source->source = lw::Owned{wl_data_device_manager_create_data_source(state.dataDeviceManager)};
+		if (source->source == nullptr)
+			return lw::makeErrorStack("Can't create data source");
+		if (wl_data_source_add_listener(source->source, &dataSourceListener, source.get()) != 0)
+			return lw::makeErrorStack("Can't add listener to data source");
+
+		source->contents.reserve(contents.size());
+		for (const DataContent& content : contents) {
+			const int fd {fcntl(content.fd, F_DUPFD_CLOEXEC, 0)};
+			if (fd < 0)
+				return lw::makeErrorStack("Can't duplicate fd of '{}' content : {}", content.mimeType, strerror(errno));
+			auto& sourceContent {source->contents.emplace_back(std::string{content.mimeType}, fd)};
+			wl_data_source_offer(source->source, sourceContent.mimeType.c_str());
+		}
+		return source;
+	}
+
+
+	auto Instance::s_startReceive(
+		internals::InstanceState& state,
+		wl_data_offer* dataOffer,
+		std::string_view mimeType,
+		int fd
+	) noexcept -> lw::Failable<internals::Transfer*> {
+		// only our end is non-blocking, the sending client may well expect a blocking pipe
+		std::array<int, 2> pipeFds {};
+		if (pipe2(pipeFds.data(), O_CLOEXEC) != 0)
+			return lw::makeErrorStack("Can't create transfer pipe : {}", strerror(errno));
+		const auto [readFd, writeFd] {pipeFds};
+		if (fcntl(readFd, F_SETFL, O_NONBLOCK) != 0) {
+			close(readFd);
+			close(writeFd);
+			return lw::makeErrorStack("Can't make transfer pipe non-blocking : {}", strerror(errno));
+		}
+		(void)fcntl(readFd, F_SETPIPE_SZ, transferPipeSize);
+
+		const int file {fcntl(fd, F_DUPFD_CLOEXEC, 0)};
+		if (file < 0) {
+			close(readFd);
+			close(writeFd);
+			return lw::makeErrorStack("Can't duplicate destination fd : {}", strerror(errno));
+		}
+
+		// the request keeps its own duplicate of the fd, ours can be closed once it is queued. It is sent with the
+		// other requests of the frame by the next flush
+		const std::string mimeTypeString {mimeType};
+		wl_data_offer_receive(dataOffer, mimeTypeString.c_str(), writeFd);
+		close(writeFd);
+
+		return &state.transfers.emplace_back(internals::Transfer{
+			.id = static_cast<lw::TransferId> (state.nextTransferId++),
+			.direction = internals::TransferDirection::receive,
+			.pipe = readFd,
+			.file = file,
+			.size = 0,
+			.dropOffer = nullptr
+		});
+	}
+
+
+	auto Instance::s_startSend(internals::InstanceState& state, int file, int pipe) noexcept -> lw::Failable<void> {
+		const int fileCopy {fcntl(file, F_DUPFD_CLOEXEC, 0)};
+		if (fileCopy < 0) {
+			close(pipe);
+			return lw::makeErrorStack("Can't duplicate sent fd : {}", strerror(errno));
+		}
+		const int flags {fcntl(pipe, F_GETFL)};
+		if (flags < 0 || fcntl(pipe, F_SETFL, flags | O_NONBLOCK) != 0) {
+			close(pipe);
+			close(fileCopy);
+			return lw::makeErrorStack("Can't make transfer pipe non-blocking : {}", strerror(errno));
+		}
+
+		state.transfers.emplace_back(internals::Transfer{
+			.id = static_cast<lw::TransferId> (state.nextTransferId++),
+			.direction = internals::TransferDirection::send,
+			.pipe = pipe,
+			.file = fileCopy,
+			.size = 0,
+			.dropOffer = nullptr
+		});
+		return {};
+	}
+
+
+	auto Instance::s_dispatchTransfers(internals::InstanceState& state, std::span<const pollfd> pollFds) noexcept
+		-> void
+	{
+		const lw::trace::Scope traceScope {"Instance::dispatchTransfers"};
+		// scanned from the back so finished transfers can be erased on the way
+		for (std::size_t i {std::min(pollFds.size(), state.transfers.size())}; i > 0; --i) {
+			if (pollFds[i - 1].revents == 0)
+				continue;
+			internals::Transfer& transfer {state.transfers[i - 1]};
+			// both directions write into an fd whose reader may be gone, the application's one when receiving
+			lw::Failable isOverWithError {callWithoutSigpipe([&transfer]() noexcept {
+				return transfer.direction == internals::TransferDirection::receive
+					? receiveTransfer(transfer)
+					: sendTransfer(transfer);
+			})};
+			if (isOverWithError && !*isOverWithError)
+				continue;
+
+			const bool isCompleted {isOverWithError.has_value()};
+			if (isCompleted && transfer.dropOffer != nullptr
+				&& wl_data_offer_get_version(transfer.dropOffer->offer) >= WL_DATA_OFFER_FINISH_SINCE_VERSION
+			)
+				wl_data_offer_finish(transfer.dropOffer->offer);
+			state.events.emplace_back(lw::TransferEvent{
+				.transfer = transfer.id,
+				.state = isCompleted ? lw::TransferState::completed : lw::TransferState::failed,
+				.size = transfer.size
+			});
+			Instance::s_closeTransfer(transfer);
+			state.transfers.erase(state.transfers.begin() + static_cast<std::ptrdiff_t> (i - 1));
+		}
+	}
+
+
+	auto Instance::s_closeTransfer(internals::Transfer& transfer) noexcept -> void {
+		if (transfer.pipe >= 0)
+			close(std::exchange(transfer.pipe, -1));
+		if (transfer.file >= 0)
+			close(std::exchange(transfer.file, -1));
+		transfer.dropOffer.reset();
+	}
+
+
+	namespace internals {
+		DataSource::~DataSource() {
+			for (const DataSourceContent& content : contents)
+				close(content.fd);
+			if (source != nullptr)
+				wl_data_source_destroy(source.release());
+		}
+	}
+}
@@ -0,0 +1,211 @@
+#include "liteway/wayland/cursor.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#include <cursor-shape-v1/cursor-shape-v1-client-protocol.h>
+#include <wayland-client-protocol.h>
+#include <wayland-cursor.h>
+
+#include "liteway/cursor.hpp"
+#include "liteway/error.hpp"
+#include "liteway/wayland/instance.hpp"
+
+
+namespace lw::wayland::internals {
+	struct CursorShapeInfos {
+		std::uint32_t shape;
+		std::array<const char*, 2> names;
+	};
+
+	static constexpr auto getCursorShapeInfos(lw::CursorShape shape) noexcept -> CursorShapeInfos {
+		switch (shape) {
+			case lw::CursorShape::arrow:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT, {"default", "left_ptr"}};
+			case lw::CursorShape::contextMenu:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CONTEXT_MENU, {"context-menu", "left_ptr"}};
+			case lw::CursorShape::help:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_HELP, {"help", "question_arrow"}};
+			case lw::CursorShape::pointer:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_POINTER, {"pointer", "hand2"}};
+			case lw::CursorShape::progress:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_PROGRESS, {"progress", "left_ptr_watch"}};
+			case lw::CursorShape::wait:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_WAIT, {"wait", "watch"}};
+			case lw::CursorShape::cell:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CELL, {"cell", "plus"}};
+			case lw::CursorShape::crosshair:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CROSSHAIR, {"crosshair", "cross"}};
+			case lw::CursorShape::text:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_TEXT, {"text", "xterm"}};
+			case lw::CursorShape::verticalText:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_VERTICAL_TEXT, {"vertical-text", "xterm"}};
+			case lw::CursorShape::alias:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ALIAS, {"alias", "dnd-link"}};
+			case lw::CursorShape::copy:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_COPY, {"copy", "dnd-copy"}};
+			case lw::CursorShape::move:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_MOVE, {"move", "fleur"}};
+			case lw::CursorShape::noDrop:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NO_DROP, {"no-drop", "dnd-no-drop"}};
+			case lw::CursorShape::notAllowed:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NOT_ALLOWED, {"not-allowed", "crossed_circle"}};
+			case lw::CursorShape::grab:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRAB, {"grab", "openhand"}};
+			case lw::CursorShape::grabbing:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_GRABBING, {"grabbing", "closedhand"}};
+			case lw::CursorShape::resizeEast:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_E_RESIZE, {"e-resize", "right_side"}};
+			case lw::CursorShape::resizeNorth:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_N_RESIZE, {"n-resize", "top_side"}};
+			case lw::CursorShape::resizeNorthEast:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NE_RESIZE, {"ne-resize", "top_right_corner"}};
+			case lw::CursorShape::resizeNorthWest:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NW_RESIZE, {"nw-resize", "top_left_corner"}};
+			case lw::CursorShape::resizeSouth:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_S_RESIZE, {"s-resize", "bottom_side"}};
+			case lw::CursorShape::resizeSouthEast:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SE_RESIZE, {"se-resize", "bottom_right_corner"}};
+			case lw::CursorShape::resizeSouthWest:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SW_RESIZE, {"sw-resize", "bottom_left_corner"}};
+			case lw::CursorShape::resizeWest:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_W_RESIZE, {"w-resize", "left_side"}};
+			case lw::CursorShape::resizeEastWest:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_EW_RESIZE, {"ew-resize", "sb_h_double_arrow"}};
+			case lw::CursorShape::resizeNorthSouth:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NS_RESIZE, {"ns-resize", "sb_v_double_arrow"}};
+			case lw::CursorShape::resizeNorthEastSouthWest:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NESW_RESIZE, {"nesw-resize", "fd_double_arrow"}};
+			case lw::CursorShape::resizeNorthWestSouthEast:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NWSE_RESIZE, {"nwse-resize", "bd_double_arrow"}};
+			case lw::CursorShape::resizeColumn:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_COL_RESIZE, {"col-resize", "sb_h_double_arrow"}};
+			case lw::CursorShape::resizeRow:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ROW_RESIZE, {"row-resize", "sb_v_double_arrow"}};
+			case lw::CursorShape::allScroll:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ALL_SCROLL, {"all-scroll", "fleur"}};
+			case lw::CursorShape::zoomIn:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ZOOM_IN, {"zoom-in", "zoom-in"}};
+			case lw::CursorShape::zoomOut:
+				return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_ZOOM_OUT, {"zoom-out", "zoom-out"}};
+			case lw::CursorShape::hidden:
+			case lw::CursorShape::count:
+				break;
+		}
+		return {WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT, {"default", "left_ptr"}};
+	}
+
+
+	auto CursorThemeCache::destroy() noexcept -> void {
+		m_attachedImage = nullptr;
+		m_cursors = {};
+		m_lookedUp = {};
+		if (m_surface != nullptr)
+			wl_surface_destroy(m_surface.release());
+		if (m_theme != nullptr)
+			wl_cursor_theme_destroy(m_theme.release());
+	}
+
+
+	auto CursorThemeCache::setCursor(
+		InstanceState& state,
+		std::uint32_t serial,
+		lw::CursorShape shape
+	) noexcept -> lw::Failable<void> {
+		lw::Failable loadResult {this->load(state)};
+		if (!loadResult)
+			return lw::pushToErrorStack(loadResult, "Can't load cursor theme");
+
+		wl_cursor* cursor {this->getCursor(shape)};
+		if (cursor == nullptr || cursor->image_count == 0)
+			return lw::makeErrorStack("Cursor theme has no cursor for shape {}", static_cast<int> (shape));
+		// animated cursors only show their first frame, which avoids a timer per cursor
+		wl_cursor_image* image {*cursor->images};
+
+		if (image != m_attachedImage) {
+			wl_buffer* buffer {wl_cursor_image_get_buffer(image)};
+			if (buffer == nullptr)
+				return lw::makeErrorStack("Can't get buffer of cursor image");
+			wl_surface_attach(m_surface, buffer, 0, 0);
+			wl_surface_damage_buffer(m_surface, 0, 0,
+				static_cast<std::int32_t> (image->width),
+				static_cast<std::int32_t> (image->height)
+			);
+			wl_surface_commit(m_surface);
+			m_attachedImage = image;
+		}
+
+		wl_pointer_set_cursor(state.pointer, serial, m_surface,
+			static_cast<std::int32_t> (image->hotspot_x),
+			static_cast<std::int32_t> (image->hotspot_y)
+		);
+		return {};
+	}
+
+
+	auto CursorThemeCache::load(InstanceState& state) noexcept -> lw::Failable<void> {
+		if (m_theme != nullptr)
+			return {};
+
+		constexpr int defaultSize {24};
+		int size {defaultSize};
+		if (const char* sizeString {std::getenv("XCURSOR_SIZE")}; sizeString != nullptr) {
+			const std::string_view sizeView {sizeString};
+			const auto result {std::from_chars(sizeView.data(), sizeView.data() + sizeView.size(), size)};
+			if (result.ec != std::errc{} || size <= 0)
+				size = defaultSize;
+		}
+
+		m_theme = lw::Owned{wl_cursor_theme_load(std::getenv("XCURSOR_THEME"), size, state.sharedMemory)};
+		if (m_theme == nullptr)
+			return lw::makeErrorStack("Can't load cursor theme of size {}", size);
+		m_surface = lw::Owned{wl_compositor_create_surface(state.compositor)};
+		if (m_surface == nullptr)
+			return lw::makeErrorStack("Can't create cursor surface");
+		return {};
+	}
+
+
+	auto CursorThemeCache::getCursor(lw::CursorShape shape) noexcept -> wl_cursor* {
+		const auto index {static_cast<std::size_t> (shape)};
+		if (m_lookedUp[index])
+			return m_cursors[index];
+
+		wl_cursor* cursor {nullptr};
+		for (const char* name : getCursorShapeInfos(shape).names) {
+			cursor = wl_cursor_theme_get_cursor(m_theme, name);
+			if (cursor != nullptr)
+				break;
+		}
+		if (cursor == nullptr)
+			cursor = wl_cursor_theme_get_cursor(m_theme, "left_ptr");
+		m_cursors[index] = cursor;
+		m_lookedUp[index] = true;
+		return cursor;
+	}
+
+
+	auto setCursorShape(InstanceState& state, std::uint32_t serial, lw::CursorShape shape) noexcept
+		-> lw::Failable<void>
+	{
+		if (state.pointer == nullptr)
+			return {};
+		if (shape == lw::CursorShape::hidden) {
+			wl_pointer_set_cursor(state.pointer, serial, nullptr, 0, 0);
+			return {};
+		}
+
+		if (state.cursorShapeDevice != nullptr) {
+			wp_cursor_shape_device_v1_set_shape(state.cursorShapeDevice, serial, getCursorShapeInfos(shape).shape);
+			return {};
+		}
+
+		lw::Failable result {state.cursorThemeCache.setCursor(state, serial, shape)};
+		if (!result)
+			return lw::pushToErrorStack(result, "Can't set cursor from fallback cursor theme");
+		return {};
+	}
+}
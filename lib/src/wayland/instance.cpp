@@ -1,14 +1,35 @@
 #include "liteway/wayland/instance.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
-
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <optional>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cursor-shape-v1/cursor-shape-v1-client-protocol.h>
+#include <relative-pointer-unstable-v1/relative-pointer-unstable-v1-client-protocol.h>
 #include <xdg-shell/xdg-shell-client-protocol.h>
 #include <wayland-client-core.h>
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
 
 #include "liteway/error.hpp"
+#include "liteway/event.hpp"
+#include "liteway/trace.hpp"
 #include "liteway/utils.hpp"
+#include "liteway/wayland/cursor.hpp"
+#include "liteway/wayland/window.hpp"
 
 
 namespace lw::wayland {
@@ -32,10 +53,69 @@ namespace lw::wayland {
 		.name = [](void*, wl_seat*, const char*) noexcept -> void {}
 	};
 
+	static const wl_pointer_listener pointerListener {
+		.enter = &Instance::handlePointerEnter,
+		.leave = &Instance::handlePointerLeave,
+		.motion = &Instance::handlePointerMotion,
+		.button = &Instance::handlePointerButton,
+		.axis = [](void*, wl_pointer*, std::uint32_t, std::uint32_t, wl_fixed_t) noexcept -> void {},
+		.frame = &Instance::handlePointerFrame,
+		.axis_source = [](void*, wl_pointer*, std::uint32_t) noexcept -> void {},
+		.axis_stop = [](void*, wl_pointer*, std::uint32_t, std::uint32_t) noexcept -> void {},
+		.axis_discrete = [](void*, wl_pointer*, std::uint32_t, std::int32_t) noexcept -> void {},
+		.axis_value120 = [](void*, wl_pointer*, std::uint32_t, std::int32_t) noexcept -> void {},
+		.axis_relative_direction = [](void*, wl_pointer*, std::uint32_t, std::uint32_t) noexcept -> void {}
+	};
+
+	static const zwp_relative_pointer_v1_listener relativePointerListener {
+		.relative_motion = &Instance::handleRelativePointerMotion
+	};
+
+	static const wl_keyboard_listener keyboardListener {
+		.keymap = [](void*, wl_keyboard*, std::uint32_t, std::int32_t fd, std::uint32_t) noexcept -> void {
+			close(fd);
+		},
+		.enter = &Instance::handleKeyboardEnter,
+		.leave = &Instance::handleKeyboardLeave,
+		.key = &Instance::handleKeyboardKey,
+		.modifiers = &Instance::handleKeyboardModifiers,
+		.repeat_info = &Instance::handleKeyboardRepeatInfo
+	};
+
+
+	static constexpr std::uint64_t nanosecondsPerSecond {1'000'000'000};
+	static constexpr std::uint64_t nanosecondsPerMillisecond {1'000'000};
+
+	static auto getMonotonicTime() noexcept -> std::uint64_t {
+		timespec time {};
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return static_cast<std::uint64_t> (time.tv_sec) * nanosecondsPerSecond
+			+ static_cast<std::uint64_t> (time.tv_nsec);
+	}
+
+	static auto toTimespec(std::uint64_t nanoseconds) noexcept -> timespec {
+		return {
+			.tv_sec = static_cast<time_t> (nanoseconds / nanosecondsPerSecond),
+			.tv_nsec = static_cast<long> (nanoseconds % nanosecondsPerSecond)
+		};
+	}
+
 
 	Instance::~Instance() {
 		if (!m_state)
 			return;
+		if (m_state->keyRepeat.timer >= 0)
+			close(std::exchange(m_state->keyRepeat.timer, -1));
+		if (m_state->relativePointer != nullptr)
+			zwp_relative_pointer_v1_destroy(m_state->relativePointer.release());
+		if (m_state->relativePointerManager != nullptr)
+			zwp_relative_pointer_manager_v1_destroy(m_state->relativePointerManager.release());
+		if (m_state->cursorShapeDevice != nullptr)
+			wp_cursor_shape_device_v1_destroy(m_state->cursorShapeDevice.release());
+		if (m_state->cursorShapeManager != nullptr)
+			wp_cursor_shape_manager_v1_destroy(m_state->cursorShapeManager.release());
+		m_state->cursorThemeCache.destroy();
+		Instance::s_destroyDataDevice(*m_state);
 		if (m_state->keyboard != nullptr)
 			wl_keyboard_destroy(m_state->keyboard.release());
 		if (m_state->pointer != nullptr)
@@ -55,11 +135,17 @@ namespace lw::wayland {
 	}
 
 
-	auto Instance::create([[maybe_unused]] CreateInfos&& createInfos) noexcept -> lw::Failable<Instance> {
+	auto Instance::create(CreateInfos&& createInfos) noexcept -> lw::Failable<Instance> {
+		const lw::trace::Scope traceScope {"Instance::create"};
 		static std::size_t instanceCount {};
 		assert(++instanceCount == 1 && "You can't create more than one instance of liteway");
 		Instance instance {};
 		instance.m_state = std::make_unique<internals::InstanceState> ();
+		instance.m_state->memoryBudget = createInfos.memoryBudget;
+		instance.m_state->pointerMotion.keepHistory = createInfos.keepPointerMotionHistory;
+		instance.m_state->keyRepeat.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (instance.m_state->keyRepeat.timer < 0)
+			return lw::makeErrorStack("Can't create key repeat timer : {}", strerror(errno));
 		instance.m_state->display = lw::Owned{wl_display_connect(nullptr)};
 		if (instance.m_state->display == nullptr)
 			return lw::makeErrorStack("Can't connect display");
@@ -87,6 +173,34 @@ namespace lw::wayland {
 		}
 		instance.m_state->registryListenerUserData.result = {};
 
+		if (instance.m_state->cursorShapeManager != nullptr) {
+			instance.m_state->cursorShapeDevice = lw::Owned{wp_cursor_shape_manager_v1_get_pointer(
+				instance.m_state->cursorShapeManager,
+				instance.m_state->pointer
+			)};
+			if (instance.m_state->cursorShapeDevice == nullptr)
+				return lw::makeErrorStack("Can't get cursor shape device of pointer");
+		}
+
+		if (instance.m_state->relativePointerManager != nullptr) {
+			instance.m_state->relativePointer = lw::Owned{zwp_relative_pointer_manager_v1_get_relative_pointer(
+				instance.m_state->relativePointerManager,
+				instance.m_state->pointer
+			)};
+			if (instance.m_state->relativePointer == nullptr)
+				return lw::makeErrorStack("Can't get relative pointer");
+			if (zwp_relative_pointer_v1_add_listener(
+				instance.m_state->relativePointer,
+				&relativePointerListener,
+				instance.m_state.get()
+			) != 0)
+				return lw::makeErrorStack("Can't add listener to relative pointer");
+		}
+
+		lw::Failable dataDeviceResult {Instance::s_createDataDevice(*instance.m_state)};
+		if (!dataDeviceResult)
+			return lw::pushToErrorStack(dataDeviceResult, "Can't create data device");
+
 		auto& supportedFormats {instance.m_state->registryListenerUserData.sharedMemoryListenerUserData.supportedFormats};
 		if (std::ranges::find(supportedFormats, WL_SHM_FORMAT_ARGB8888) == supportedFormats.end())
 			return lw::makeErrorStack("Needed shared memory format 'WL_SHM_FORMAT_ARGB8888' is not supported");
@@ -95,12 +209,125 @@ namespace lw::wayland {
 
 
 	auto Instance::update() noexcept -> lw::Failable<void> {
-		if (wl_display_dispatch(m_state->display) < 0)
+		const lw::trace::Scope traceScope {"Instance::update"};
+		wl_display* display {m_state->display};
+		lw::Failable flushResult {Instance::s_flush(*m_state)};
+		if (!flushResult)
+			return lw::pushToErrorStack(flushResult, "Can't flush requests of the frame");
+
+		ConnectionStatistics& statistics {m_state->connectionStatistics};
+		m_state->frameConnectionStatistics = std::exchange(statistics, ConnectionStatistics{});
+		lw::trace::counter("Send calls", m_state->frameConnectionStatistics.sendCount);
+		lw::trace::counter("Sent bytes", static_cast<std::int64_t> (m_state->frameConnectionStatistics.sentBytes));
+		lw::trace::counter("Receive calls", m_state->frameConnectionStatistics.receiveCount);
+
+		// like `wl_display_dispatch`, already queued events are dispatched without waiting for new ones
+		if (wl_display_prepare_read(display) != 0) {
+			const int eventCount {wl_display_dispatch_pending(display)};
+			if (eventCount < 0)
+				return lw::makeErrorStack("Can't dispatch pending events of display");
+			statistics.eventCount += static_cast<std::uint32_t> (eventCount);
+			Instance::s_publishInputState(*m_state);
+			return {};
+		}
+
+		// transfers come after the display and the key repeat timer, in the same order as `transfers`
+		std::vector<pollfd>& pollFds {m_state->pollFds};
+		pollFds.clear();
+		pollFds.push_back({
+			.fd = wl_display_get_fd(display),
+			.events = static_cast<short> (m_state->isFlushPending ? POLLIN | POLLOUT : POLLIN),
+			.revents = 0
+		});
+		pollFds.push_back({.fd = m_state->keyRepeat.timer, .events = POLLIN, .revents = 0});
+		for (const internals::Transfer& transfer : m_state->transfers) {
+			pollFds.push_back({
+				.fd = transfer.pipe,
+				.events = static_cast<short> (transfer.direction == internals::TransferDirection::receive
+					? POLLIN
+					: POLLOUT
+				),
+				.revents = 0
+			});
+		}
+		while (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			wl_display_cancel_read(display);
+			return lw::makeErrorStack("Can't poll display : {}", strerror(errno));
+		}
+
+		if ((pollFds[0].revents & POLLIN) != 0) {
+			++statistics.receiveCount;
+			if (wl_display_read_events(display) < 0)
+				return lw::makeErrorStack("Can't read display events : {}", strerror(errno));
+		}
+		else {
+			wl_display_cancel_read(display);
+			if ((pollFds[0].revents & (POLLERR | POLLHUP)) != 0)
+				return lw::makeErrorStack("Display connection was closed");
+		}
+		if ((pollFds[0].revents & POLLOUT) != 0) {
+			flushResult = Instance::s_flush(*m_state);
+			if (!flushResult)
+				return lw::pushToErrorStack(flushResult, "Can't flush requests left by a full socket");
+		}
+
+		// a release read in this batch must stop the repeat before the timer is serviced
+		const int eventCount {wl_display_dispatch_pending(display)};
+		if (eventCount < 0)
 			return lw::makeErrorStack("Can't dispatch display");
+		statistics.eventCount += static_cast<std::uint32_t> (eventCount);
+
+		if ((pollFds[1].revents & POLLIN) != 0) {
+			lw::Failable repeatResult {Instance::s_dispatchKeyRepeats(*m_state)};
+			if (!repeatResult)
+				return lw::pushToErrorStack(repeatResult, "Can't dispatch key repeats");
+		}
+		Instance::s_dispatchTransfers(*m_state, std::span{pollFds}.subspan(2));
+		Instance::s_publishInputState(*m_state);
 		return {};
 	}
 
 
+	auto Instance::flush() noexcept -> lw::Failable<void> {
+		return Instance::s_flush(*m_state);
+	}
+
+
+	auto Instance::pollEvent() noexcept -> std::optional<lw::Event> {
+		if (m_state->events.empty())
+			return std::nullopt;
+		lw::Event event {std::move(m_state->events.front())};
+		m_state->events.pop_front();
+		return event;
+	}
+
+
+	auto Instance::getInputState() const noexcept -> lw::InputState {
+		return m_state->publishedInput.load();
+	}
+
+
+	auto Instance::getConnectionStatistics() const noexcept -> ConnectionStatistics {
+		return m_state->frameConnectionStatistics;
+	}
+
+
+	auto Instance::getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+		return m_state->memoryStatistics;
+	}
+
+
+	auto Instance::setMemoryBudget(std::size_t memoryBudget) noexcept -> void {
+		m_state->memoryBudget = memoryBudget;
+		if (m_state->memoryStatistics.mappedBytes <= memoryBudget)
+			return;
+		for (internals::WindowState* window : m_state->windows)
+			Window::s_trimBuffers(*window);
+	}
+
+
 	template <>
 	auto Instance::bindGlobalFromRegistry<wl_compositor> (
 		internals::RegistryListenerUserData& registryListenerUserData,
@@ -178,6 +405,61 @@ namespace lw::wayland {
 	}
 
 
+	template <>
+	auto Instance::bindGlobalFromRegistry<wp_cursor_shape_manager_v1> (
+		internals::RegistryListenerUserData& registryListenerUserData,
+		std::uint32_t name,
+		std::uint32_t version
+	) noexcept -> lw::Failable<void> {
+		// the generated protocol code only knows the requests and events up to its own version
+		const auto maxVersion {static_cast<std::uint32_t> (wp_cursor_shape_manager_v1_interface.version)};
+		internals::InstanceState& state {registryListenerUserData.state};
+		state.cursorShapeManager = lw::Owned{static_cast<wp_cursor_shape_manager_v1*> (
+			wl_registry_bind(state.registry, name, &wp_cursor_shape_manager_v1_interface, std::min(version, maxVersion))
+		)};
+		if (state.cursorShapeManager == nullptr)
+			return lw::makeErrorStack("Can't bind cursor shape manager");
+		return {};
+	}
+
+
+	template <>
+	auto Instance::bindGlobalFromRegistry<zwp_relative_pointer_manager_v1> (
+		internals::RegistryListenerUserData& registryListenerUserData,
+		std::uint32_t name,
+		std::uint32_t version
+	) noexcept -> lw::Failable<void> {
+		const auto maxVersion {static_cast<std::uint32_t> (zwp_relative_pointer_manager_v1_interface.version)};
+		internals::InstanceState& state {registryListenerUserData.state};
+		state.relativePointerManager = lw::Owned{static_cast<zwp_relative_pointer_manager_v1*> (
+			wl_registry_bind(state.registry, name, &zwp_relative_pointer_manager_v1_interface,
+				std::min(version, maxVersion)
+			)
+		)};
+		if (state.relativePointerManager == nullptr)
+			return lw::makeErrorStack("Can't bind relative pointer manager");
+		return {};
+	}
+
+
+	template <>
+	auto Instance::bindGlobalFromRegistry<wl_data_device_manager> (
+		internals::RegistryListenerUserData& registryListenerUserData,
+		std::uint32_t name,
+		std::uint32_t version
+	) noexcept -> lw::Failable<void> {
+		// version 3 brings drag and drop actions, nothing after it is used
+		constexpr std::uint32_t maxVersion {3};
+		internals::InstanceState& state {registryListenerUserData.state};
+		state.dataDeviceManager = lw::Owned{static_cast<wl_data_device_manager*> (
+			wl_registry_bind(state.registry, name, &wl_data_device_manager_interface, std::min(version, maxVersion))
+		)};
+		if (state.dataDeviceManager == nullptr)
+			return lw::makeErrorStack("Can't bind data device manager");
+		return {};
+	}
+
+
 	auto Instance::handleRegistryGlobal(
 		void* data,
 		[[maybe_unused]] wl_registry* registry,
@@ -190,12 +472,21 @@ namespace lw::wayland {
 		if (!registryListenerUserData.result)
 			return;
 
-		using Interfaces = std::tuple<wl_compositor, xdg_wm_base, wl_shm, wl_seat>;
+		using Interfaces = std::tuple<
+			wl_compositor,
+			xdg_wm_base,
+			wl_shm,
+			wl_seat,
+			wp_cursor_shape_manager_v1,
+			zwp_relative_pointer_manager_v1,
+			wl_data_device_manager
+		>;
 
 		registryListenerUserData.result = [&] <std::size_t I = 0> (this const auto& self) noexcept
 			-> lw::Failable<void>
 		{
 			if (interface == lw::utils::getTypeName<std::tuple_element_t<I, Interfaces>> ()) {
+				const lw::trace::Scope traceScope {lw::utils::getTypeName<std::tuple_element_t<I, Interfaces>> ()};
 				return bindGlobalFromRegistry<std::tuple_element_t<I, Interfaces>> (
 					registryListenerUserData,
 					name,
@@ -232,8 +523,378 @@ namespace lw::wayland {
 		state.pointer = lw::Owned{wl_seat_get_pointer(seat)};
 		if (state.pointer == nullptr)
 			return (void)(result = lw::makeErrorStack("Can't get seat pointer"));
+		if (wl_pointer_add_listener(state.pointer, &pointerListener, &state) != 0)
+			return (void)(result = lw::makeErrorStack("Can't add listener to seat pointer"));
 		state.keyboard = lw::Owned{wl_seat_get_keyboard(seat)};
 		if (state.keyboard == nullptr)
 			return (void)(result = lw::makeErrorStack("Can't get seat keyboard"));
+		if (wl_keyboard_add_listener(state.keyboard, &keyboardListener, &state) != 0)
+			return (void)(result = lw::makeErrorStack("Can't add listener to seat keyboard"));
+	}
+
+
+	auto Instance::handlePointerEnter(
+		void* data,
+		[[maybe_unused]] wl_pointer* pointer,
+		std::uint32_t serial,
+		wl_surface* surface,
+		wl_fixed_t x,
+		wl_fixed_t y
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		Instance::s_flushPointerMotion(state);
+		state.pointerEnterSerial = serial;
+		state.pointerFocus = surface;
+		state.pointerMotion.lastX = wl_fixed_to_double(x);
+		state.pointerMotion.lastY = wl_fixed_to_double(y);
+		state.input.pointerFocus = internals::getWindowId(surface);
+		state.input.pointerX = state.pointerMotion.lastX;
+		state.input.pointerY = state.pointerMotion.lastY;
+		state.isInputDirty = true;
+		if (surface == nullptr)
+			return;
+		const auto* windowState {static_cast<const internals::WindowState*> (wl_surface_get_user_data(surface))};
+		if (windowState == nullptr)
+			return;
+		// a cursor that can't be set isn't worth failing the whole dispatch for
+		(void)internals::setCursorShape(state, serial, windowState->cursorShape);
+	}
+
+
+	auto Instance::handlePointerLeave(
+		void* data,
+		[[maybe_unused]] wl_pointer* pointer,
+		[[maybe_unused]] std::uint32_t serial,
+		wl_surface* surface
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		Instance::s_flushPointerMotion(state);
+		if (state.pointerFocus != surface)
+			return;
+		state.pointerFocus = nullptr;
+		// buttons released outside of the window aren't reported to it
+		state.input.pointerFocus = lw::WindowId{};
+		state.input.buttons = 0;
+		state.isInputDirty = true;
+	}
+
+
+	auto Instance::handlePointerMotion(
+		void* data,
+		wl_pointer* pointer,
+		[[maybe_unused]] std::uint32_t time,
+		wl_fixed_t x,
+		wl_fixed_t y
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		lw::PointerMotionEvent& motion {Instance::s_getPendingPointerMotion(state)};
+		motion.x = wl_fixed_to_double(x);
+		motion.y = wl_fixed_to_double(y);
+		motion.deltaX += motion.x - state.pointerMotion.lastX;
+		motion.deltaY += motion.y - state.pointerMotion.lastY;
+		++motion.motionCount;
+		state.pointerMotion.lastX = motion.x;
+		state.pointerMotion.lastY = motion.y;
+		state.input.pointerX = motion.x;
+		state.input.pointerY = motion.y;
+		state.isInputDirty = true;
+
+		// before version 5 there are no frame events to group motions with
+		if (wl_pointer_get_version(pointer) < WL_POINTER_FRAME_SINCE_VERSION)
+			Instance::s_flushPointerMotion(state);
+	}
+
+
+	auto Instance::handlePointerButton(
+		void* data,
+		[[maybe_unused]] wl_pointer* pointer,
+		std::uint32_t serial,
+		[[maybe_unused]] std::uint32_t time,
+		std::uint32_t button,
+		std::uint32_t buttonState
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		const bool isPressed {buttonState == WL_POINTER_BUTTON_STATE_PRESSED};
+		state.inputSerial = serial;
+		if (isPressed)
+			state.pointerButtonSerial = serial;
+		state.input.setButton(button, isPressed);
+		state.isInputDirty = true;
+	}
+
+
+	auto Instance::handlePointerFrame(void* data, [[maybe_unused]] wl_pointer* pointer) noexcept -> void {
+		Instance::s_flushPointerMotion(*static_cast<internals::InstanceState*> (data));
+	}
+
+
+	auto Instance::handleRelativePointerMotion(
+		void* data,
+		[[maybe_unused]] zwp_relative_pointer_v1* relativePointer,
+		[[maybe_unused]] std::uint32_t timeHigh,
+		[[maybe_unused]] std::uint32_t timeLow,
+		[[maybe_unused]] wl_fixed_t deltaX,
+		[[maybe_unused]] wl_fixed_t deltaY,
+		wl_fixed_t unacceleratedDeltaX,
+		wl_fixed_t unacceleratedDeltaY
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		lw::PointerMotionEvent& motion {Instance::s_getPendingPointerMotion(state)};
+		motion.unacceleratedDeltaX += wl_fixed_to_double(unacceleratedDeltaX);
+		motion.unacceleratedDeltaY += wl_fixed_to_double(unacceleratedDeltaY);
+	}
+
+
+	auto Instance::handleKeyboardEnter(
+		void* data,
+		[[maybe_unused]] wl_keyboard* keyboard,
+		std::uint32_t serial,
+		wl_surface* surface,
+		wl_array* keys
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.keyboardFocus = surface;
+		state.inputSerial = serial;
+		state.input.keyboardFocus = internals::getWindowId(surface);
+		state.input.keys = {};
+		const std::span<const std::uint32_t> pressedKeys {
+			static_cast<const std::uint32_t*> (keys->data),
+			keys->size / sizeof(std::uint32_t)
+		};
+		for (const std::uint32_t key : pressedKeys)
+			state.input.setKey(key, true);
+		state.isInputDirty = true;
+		// a key held while the focus arrives repeats as if it was pressed now, the last one is the latest pressed
+		if (!pressedKeys.empty())
+			Instance::s_startKeyRepeat(state, pressedKeys.back(), getMonotonicTime());
+	}
+
+
+	auto Instance::handleKeyboardLeave(
+		void* data,
+		[[maybe_unused]] wl_keyboard* keyboard,
+		[[maybe_unused]] std::uint32_t serial,
+		[[maybe_unused]] wl_surface* surface
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.keyboardFocus = nullptr;
+		Instance::s_stopKeyRepeat(state);
+		state.input.keyboardFocus = lw::WindowId{};
+		state.input.keys = {};
+		state.input.modifiers = {};
+		state.isInputDirty = true;
+	}
+
+
+	auto Instance::handleKeyboardKey(
+		void* data,
+		[[maybe_unused]] wl_keyboard* keyboard,
+		std::uint32_t serial,
+		[[maybe_unused]] std::uint32_t time,
+		std::uint32_t key,
+		std::uint32_t keyState
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.inputSerial = serial;
+		const bool isPressed {keyState == WL_KEYBOARD_KEY_STATE_PRESSED};
+		// repeats that fired before this key event must come before it, a failed read just loses them
+		static_cast<void> (Instance::s_dispatchKeyRepeats(state));
+		/*
+		 * The compositor's time is in milliseconds, 32 bits and of unspecified base. Stamping at dispatch keeps every
+		 * event on the same clock as the repeats, which are scheduled from the press's timestamp
+		 */
+		const std::uint64_t timestamp {getMonotonicTime()};
+		state.events.emplace_back(lw::KeyEvent{
+			.window = internals::getWindowId(state.keyboardFocus),
+			.key = key,
+			.state = isPressed ? lw::KeyState::pressed : lw::KeyState::released,
+			.timestamp = timestamp
+		});
+
+		state.input.setKey(key, isPressed);
+		state.isInputDirty = true;
+
+		if (isPressed)
+			Instance::s_startKeyRepeat(state, key, timestamp);
+		else if (state.keyRepeat.key == key)
+			Instance::s_stopKeyRepeat(state);
+	}
+
+
+	auto Instance::handleKeyboardModifiers(
+		void* data,
+		[[maybe_unused]] wl_keyboard* keyboard,
+		[[maybe_unused]] std::uint32_t serial,
+		std::uint32_t depressed,
+		std::uint32_t latched,
+		std::uint32_t locked,
+		[[maybe_unused]] std::uint32_t group
+	) noexcept -> void {
+		/*
+		 * Masks are indexed by the modifiers of the keymap. Without parsing it with xkbcommon, this relies on the
+		 * eight X11 real modifiers coming first in their usual order, which every keymap made by xkbcommon does
+		 */
+		enum RealModifier : std::uint8_t {shift, lock, control, mod1, mod2, mod3, mod4, mod5};
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		const std::uint32_t active {depressed | latched | locked};
+		const auto isActive {[active](RealModifier modifier) noexcept -> bool {
+			return ((active >> modifier) & 1u) != 0;
+		}};
+		state.input.modifiers = lw::Modifiers{
+			.shift = isActive(shift),
+			.capsLock = isActive(lock),
+			.control = isActive(control),
+			.alt = isActive(mod1),
+			.super = isActive(mod4),
+			.numLock = isActive(mod2)
+		};
+		state.isInputDirty = true;
+	}
+
+
+	auto Instance::handleKeyboardRepeatInfo(
+		void* data,
+		[[maybe_unused]] wl_keyboard* keyboard,
+		std::int32_t rate,
+		std::int32_t delay
+	) noexcept -> void {
+		auto& state {*static_cast<internals::InstanceState*> (data)};
+		state.keyRepeat.rate = std::max(rate, 0);
+		state.keyRepeat.delay = static_cast<std::uint64_t> (std::max(delay, 0)) * nanosecondsPerMillisecond;
+		if (state.keyRepeat.rate == 0)
+			Instance::s_stopKeyRepeat(state);
+	}
+
+
+	auto Instance::s_flush(internals::InstanceState& state) noexcept -> lw::Failable<void> {
+		const int sentBytes {wl_display_flush(state.display)};
+		if (sentBytes < 0) {
+			if (errno != EAGAIN)
+				return lw::makeErrorStack("Can't flush display : {}", strerror(errno));
+			// what was sent before the socket filled up isn't reported by libwayland
+			++state.connectionStatistics.sendCount;
+			state.isFlushPending = true;
+			return {};
+		}
+		state.isFlushPending = false;
+		// nothing queued means libwayland didn't call `sendmsg`
+		if (sentBytes > 0) {
+			++state.connectionStatistics.sendCount;
+			state.connectionStatistics.sentBytes += static_cast<std::size_t> (sentBytes);
+		}
+		return {};
+	}
+
+
+	auto Instance::s_publishInputState(internals::InstanceState& state) noexcept -> void {
+		if (!std::exchange(state.isInputDirty, false))
+			return;
+		state.publishedInput.store(state.input);
+	}
+
+
+	auto Instance::s_getPendingPointerMotion(internals::InstanceState& state) noexcept -> lw::PointerMotionEvent& {
+		internals::PointerMotion& pointerMotion {state.pointerMotion};
+		if (!pointerMotion.pending) {
+			pointerMotion.pending = lw::PointerMotionEvent{
+				.window = internals::getWindowId(state.pointerFocus),
+				.x = pointerMotion.lastX,
+				.y = pointerMotion.lastY,
+				.deltaX = 0.0,
+				.deltaY = 0.0,
+				.unacceleratedDeltaX = 0.0,
+				.unacceleratedDeltaY = 0.0,
+				.motionCount = 0,
+				.timestamp = 0
+			};
+		}
+		return *pointerMotion.pending;
+	}
+
+
+	auto Instance::s_flushPointerMotion(internals::InstanceState& state) noexcept -> void {
+		internals::PointerMotion& pointerMotion {state.pointerMotion};
+		if (!pointerMotion.pending)
+			return;
+		lw::PointerMotionEvent& motion {*pointerMotion.pending};
+		/*
+		 * wl_pointer's milliseconds and relative pointer's microseconds are two clocks of unspecified base, so motions
+		 * are stamped when flushed, like key events
+		 */
+		motion.timestamp = getMonotonicTime();
+
+		// only the last queued event is merged into, so motions never get reordered with other events
+		auto* lastMotion {state.events.empty() || pointerMotion.keepHistory
+			? nullptr
+			: std::get_if<lw::PointerMotionEvent> (&state.events.back())
+		};
+		if (lastMotion != nullptr && lastMotion->window == motion.window) {
+			lastMotion->x = motion.x;
+			lastMotion->y = motion.y;
+			lastMotion->deltaX += motion.deltaX;
+			lastMotion->deltaY += motion.deltaY;
+			lastMotion->unacceleratedDeltaX += motion.unacceleratedDeltaX;
+			lastMotion->unacceleratedDeltaY += motion.unacceleratedDeltaY;
+			lastMotion->motionCount += motion.motionCount;
+			lastMotion->timestamp = motion.timestamp;
+		}
+		else
+			state.events.emplace_back(motion);
+		pointerMotion.pending.reset();
+	}
+
+
+	auto Instance::s_startKeyRepeat(
+		internals::InstanceState& state,
+		std::uint32_t key,
+		std::uint64_t pressTimestamp
+	) noexcept -> void {
+		if (state.keyRepeat.rate <= 0)
+			return;
+		const std::uint64_t interval {nanosecondsPerSecond / static_cast<std::uint64_t> (state.keyRepeat.rate)};
+		state.keyRepeat.key = key;
+		state.keyRepeat.nextTimestamp = pressTimestamp + state.keyRepeat.delay;
+
+		const itimerspec timerSpec {
+			.it_interval = toTimespec(interval),
+			.it_value = toTimespec(state.keyRepeat.nextTimestamp)
+		};
+		if (timerfd_settime(state.keyRepeat.timer, TFD_TIMER_ABSTIME, &timerSpec, nullptr) != 0)
+			state.keyRepeat.key = std::nullopt;
+	}
+
+
+	auto Instance::s_stopKeyRepeat(internals::InstanceState& state) noexcept -> void {
+		if (!state.keyRepeat.key)
+			return;
+		state.keyRepeat.key = std::nullopt;
+		const itimerspec timerSpec {};
+		(void)timerfd_settime(state.keyRepeat.timer, 0, &timerSpec, nullptr);
+	}
+
+
+	auto Instance::s_dispatchKeyRepeats(internals::InstanceState& state) noexcept -> lw::Failable<void> {
+		// the timer is disarmed without a held key, which also drops its expirations, so there is nothing to read
+		if (!state.keyRepeat.key || state.keyRepeat.rate <= 0)
+			return {};
+		std::uint64_t expirationCount {};
+		if (read(state.keyRepeat.timer, &expirationCount, sizeof(expirationCount)) < 0) {
+			if (errno == EAGAIN)
+				return {};
+			return lw::makeErrorStack("Can't read key repeat timer : {}", strerror(errno));
+		}
+
+		// each repeat gets the time it was scheduled at rather than the time the loop woke up
+		const std::uint64_t interval {nanosecondsPerSecond / static_cast<std::uint64_t> (state.keyRepeat.rate)};
+		for (std::uint64_t i {0}; i < expirationCount; ++i) {
+			state.events.emplace_back(lw::KeyEvent{
+				.window = internals::getWindowId(state.keyboardFocus),
+				.key = *state.keyRepeat.key,
+				.state = lw::KeyState::repeated,
+				.timestamp = state.keyRepeat.nextTimestamp
+			});
+			state.keyRepeat.nextTimestamp += interval;
+		}
+		return {};
 	}
 }
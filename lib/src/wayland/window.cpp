@@ -3,11 +3,16 @@
 #include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -17,91 +22,382 @@
 #include <xdg-shell/xdg-shell-client-protocol.h>
 
 #include "liteway/color.hpp"
+#include "liteway/cursor.hpp"
 #include "liteway/error.hpp"
+#include "liteway/hash.hpp"
+#include "liteway/image.hpp"
 #include "liteway/janitor.hpp"
+#include "liteway/memory.hpp"
+#include "liteway/trace.hpp"
+#include "liteway/wayland/capture.hpp"
+#include "liteway/wayland/cursor.hpp"
 #include "liteway/wayland/instance.hpp"
 
 
 namespace lw::wayland {
 	static const xdg_surface_listener xdgSurfaceListener {
-		.configure = [](void*, xdg_surface* surface, std::uint32_t serial) noexcept -> void {
+		.configure = [](void* data, xdg_surface* surface, std::uint32_t serial) noexcept -> void {
+			static_cast<internals::WindowState*> (data)->isConfigured = true;
 			xdg_surface_ack_configure(surface, serial);
 		}
 	};
 
+	static const xdg_toplevel_listener toplevelListener {
+		.configure = &Window::handleToplevelConfigure,
+		.close = [](void*, xdg_toplevel*) noexcept -> void {},
+		.configure_bounds = [](void*, xdg_toplevel*, std::int32_t, std::int32_t) noexcept -> void {},
+		.wm_capabilities = [](void*, xdg_toplevel*, wl_array*) noexcept -> void {}
+	};
+
+	static const wl_buffer_listener bufferListener {
+		.release = &Window::handleBufferRelease
+	};
+
+	static const wl_callback_listener frameListener {
+		.done = &Window::handleFrameDone
+	};
+
 
 	Window::~Window() {
-		if (!m_bufferData.empty()) {
-			munmap(m_bufferData.data(), m_bufferData.size());
-			m_bufferData = lw::OwnedSpan<std::byte> {nullptr, nullptr};
+		this->destroy();
+	}
+
+
+	auto Window::operator=(Window&& other) noexcept -> Window& {
+		if (this == &other)
+			return *this;
+		// the instance, the listeners and the capture all point into the state, so it can't just be dropped
+		this->destroy();
+		m_state = std::move(other.m_state);
+		m_surface = std::move(other.m_surface);
+		m_xdgSurface = std::move(other.m_xdgSurface);
+		m_toplevel = std::move(other.m_toplevel);
+		return *this;
+	}
+
+
+	auto Window::destroy() noexcept -> void {
+		if (!m_state)
+			return;
+		internals::InstanceState& instanceState {m_state->instance};
+		if (instanceState.pointerFocus == m_surface.get()) {
+			instanceState.pointerFocus = nullptr;
+			instanceState.input.pointerFocus = lw::WindowId{};
+			instanceState.isInputDirty = true;
+		}
+		if (instanceState.dragFocus == m_surface.get())
+			instanceState.dragFocus = nullptr;
+		if (instanceState.keyboardFocus == m_surface.get()) {
+			instanceState.keyboardFocus = nullptr;
+			instanceState.input.keyboardFocus = lw::WindowId{};
+			instanceState.isInputDirty = true;
+			Instance::s_stopKeyRepeat(instanceState);
 		}
-		if (m_buffer != nullptr)
-			wl_buffer_destroy(m_buffer.release());
+		std::erase(instanceState.windows, m_state.get());
+
+		if (m_state->frameCallback != nullptr)
+			wl_callback_destroy(m_state->frameCallback.release());
+		static_cast<void> (this->stopCapture());
+		while (!m_state->buffers.empty())
+			Window::s_destroyBuffer(*m_state, *m_state->buffers.back());
 		if (m_toplevel != nullptr)
 			xdg_toplevel_destroy(m_toplevel.release());
 		if (m_xdgSurface != nullptr)
 			xdg_surface_destroy(m_xdgSurface.release());
 		if (m_surface != nullptr)
 			wl_surface_destroy(m_surface.release());
+		m_state.reset();
 	}
 
 
 	auto Window::create(const CreateInfos& createInfos) noexcept -> lw::Failable<Window> {
+		const bool usesSharedMemory {createInfos.presentation == Presentation::sharedMemory};
+		// same check as the headless backend, so both behave alike on invalid infos
+		if (usesSharedMemory && createInfos.bufferCount == 0)
+			return lw::makeErrorStack("A window needs at least one buffer");
+		internals::InstanceState& instanceState {*createInfos.instance.m_state};
 		Window window {};
+		window.m_state = std::make_unique<internals::WindowState> (internals::WindowState{
+			.instance = instanceState,
+			.cursorShape = lw::CursorShape::arrow,
+			.name = std::string{createInfos.title},
+			.width = createInfos.width,
+			.height = createInfos.height,
+			.usesSharedMemory = usesSharedMemory,
+			.maxBufferCount = usesSharedMemory ? createInfos.bufferCount : 0uz,
+			.buffers = {},
+			.damageTileSize = usesSharedMemory ? createInfos.damageTileSize : 0
+		});
+		instanceState.windows.push_back(window.m_state.get());
 
-		window.m_surface = Owned{wl_compositor_create_surface(createInfos.instance.m_state->compositor)};
+		window.m_surface = Owned{wl_compositor_create_surface(instanceState.compositor)};
 		if (window.m_surface == nullptr)
 			return lw::makeErrorStack("Can't create wayland surface");
+		wl_surface_set_user_data(window.m_surface, window.m_state.get());
 
-		window.m_xdgSurface = Owned{xdg_wm_base_get_xdg_surface(
-			createInfos.instance.m_state->windowManagerBase, window.m_surface
-		)};
+		window.m_xdgSurface = Owned{xdg_wm_base_get_xdg_surface(instanceState.windowManagerBase, window.m_surface)};
 		if (window.m_xdgSurface == nullptr)
 			return lw::makeErrorStack("Can't create xdg surface");
 
-		if (xdg_surface_add_listener(window.m_xdgSurface, &xdgSurfaceListener, nullptr) != 0)
+		if (xdg_surface_add_listener(window.m_xdgSurface, &xdgSurfaceListener, window.m_state.get()) != 0)
 			return lw::makeErrorStack("Can't add listener to xdg surface");
 
 		window.m_toplevel = Owned{xdg_surface_get_toplevel(window.m_xdgSurface)};
 		if (window.m_toplevel == nullptr)
 			return lw::makeErrorStack("Can't get xdg surface's toplevel");
+		if (xdg_toplevel_add_listener(window.m_toplevel, &toplevelListener, window.m_state.get()) != 0)
+			return lw::makeErrorStack("Can't add listener to xdg toplevel");
+		xdg_toplevel_set_title(window.m_toplevel, window.m_state->name.c_str());
 
-		lw::Failable bufferWithError {Window::s_createBuffer(
-			createInfos.title,
-			createInfos.instance.m_state->sharedMemory,
-			createInfos.width,
-			createInfos.height
-		)};
-		if (!bufferWithError)
-			return lw::pushToErrorStack(bufferWithError, "Can't create buffer for surface");
-		auto& [buffer, bufferData] {*bufferWithError};
-		window.m_buffer = std::move(buffer);
-		window.m_bufferData = std::move(bufferData);
-
-		wl_surface_attach(window.m_surface, window.m_buffer, 0, 0);
+		/*
+		 * xdg-shell forbids attaching a buffer before the first configure. Waiting goes through the instance rather
+		 * than `wl_display_dispatch` so its flushes are counted and a full socket is tracked
+		 */
 		wl_surface_commit(window.m_surface);
+		while (!window.m_state->isConfigured) {
+			lw::Failable updateResult {createInfos.instance.update()};
+			if (!updateResult)
+				return lw::pushToErrorStack(updateResult, "Can't update while waiting for the first configure");
+		}
+		if (!usesSharedMemory)
+			return window;
 
-		(void)window.fill({.r = 0, .g = 0, .b = 0, .a = 170});
+		lw::Failable fillResult {window.fill({.r = 0, .g = 0, .b = 0, .a = 170})};
+		if (!fillResult)
+			return lw::pushToErrorStack(fillResult, "Can't fill the first frame of the window");
+		lw::Failable presentResult {window.present()};
+		if (!presentResult)
+			return lw::pushToErrorStack(presentResult, "Can't present the first frame of the window");
 		return window;
 	}
 
 
-	auto Window::fill(const lw::Color& color) noexcept -> lw::Failable<void> {
-		assert((m_bufferData.size() & 0b11) == 0b00 && "Buffer size must be a multiple of 4, so it can be uint32_t");
+	auto Window::getId() const noexcept -> lw::WindowId {
+		return internals::getWindowId(m_surface);
+	}
+
+
+	auto Window::getWidth() const noexcept -> std::uint32_t {
+		return m_state->width;
+	}
+
+
+	auto Window::getHeight() const noexcept -> std::uint32_t {
+		return m_state->height;
+	}
+
+
+	auto Window::getNativeHandles() const noexcept -> NativeHandles {
+		return {
+			.display = m_state->instance.display,
+			.surface = m_surface
+		};
+	}
+
+
+	auto Window::getBackBuffer() noexcept -> lw::Failable<lw::ImageView> {
+		if (!m_state->usesSharedMemory)
+			return lw::makeErrorStack("Window '{}' is presented natively and has no buffer", m_state->name);
+		if (m_state->backBuffer == nullptr) {
+			lw::Failable bufferWithError {Window::s_acquireBuffer(*m_state)};
+			if (!bufferWithError)
+				return lw::pushToErrorStack(bufferWithError, "Can't acquire a buffer to draw into");
+			m_state->backBuffer = *bufferWithError;
+		}
+
+		const lw::OwnedSpan<std::byte>& data {m_state->backBuffer->data};
+		assert((data.size() & 0b11) == 0b00 && "Buffer size must be a multiple of 4, so it can be uint32_t");
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-		assert((reinterpret_cast<std::uintptr_t> (m_bufferData.data()) & 0b11) == 0b00
+		assert((reinterpret_cast<std::uintptr_t> (data.data()) & 0b11) == 0b00
 			&& "Buffer must be aligned to 4 bytes, so it can be uint32_t"
 		);
-		const std::span<std::uint32_t> bufferDataAsU32 {
+		return lw::ImageView{
 			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-			reinterpret_cast<std::uint32_t*> (m_bufferData.data()),
-			m_bufferData.size() >> 2uz
+			.pixels = {reinterpret_cast<std::uint32_t*> (data.data()), data.size() >> 2uz},
+			.width = m_state->width,
+			.height = m_state->height,
+			.stride = m_state->width
 		};
-		std::ranges::fill(bufferDataAsU32, colorToUint32(color));
+	}
+
+
+	auto Window::fill(const lw::Color& color) noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"Window::fill"};
+		lw::Failable backBufferWithError {this->getBackBuffer()};
+		if (!backBufferWithError)
+			return lw::pushToErrorStack(backBufferWithError, "Can't get back buffer to fill");
+		std::ranges::fill(backBufferWithError->pixels, colorToUint32(color));
 		return {};
 	}
 
 
+	auto Window::present() noexcept -> lw::Failable<void> {
+		const lw::trace::Scope traceScope {"Window::present"};
+		if (!m_state->usesSharedMemory)
+			return lw::makeErrorStack("Window '{}' is presented natively, present through the graphics API",
+				m_state->name
+			);
+		if (m_state->backBuffer == nullptr)
+			return lw::makeErrorStack("Can't present a window that has nothing drawn into its back buffer");
+		internals::Buffer& buffer {*m_state->backBuffer};
+		m_state->backBuffer = nullptr;
+
+		if (m_state->damageTileSize != 0)
+			Window::s_findDamagedTiles(*m_state, buffer);
+		/*
+		 * An unchanged buffer isn't attached, so it stays free for the next frame. Its pixels are those of the last
+		 * presented frame, so a capture still records it and keeps its timing
+		 */
+		if (m_state->damageTileSize == 0 || m_state->damagedTileCount != 0) {
+			if (m_state->frameCallback == nullptr) {
+				m_state->frameCallback = lw::Owned{wl_surface_frame(m_surface)};
+				if (m_state->frameCallback == nullptr)
+					return lw::makeErrorStack("Can't request frame callback");
+				if (wl_callback_add_listener(m_state->frameCallback, &frameListener, m_state.get()) != 0)
+					return lw::makeErrorStack("Can't add listener to frame callback");
+			}
+
+			wl_surface_attach(m_surface, buffer.buffer, 0, 0);
+			if (m_state->damageTileSize == 0) {
+				wl_surface_damage_buffer(m_surface, 0, 0,
+					static_cast<std::int32_t> (m_state->width),
+					static_cast<std::int32_t> (m_state->height)
+				);
+			}
+			for (const internals::DamageRegion& region : m_state->damageRegions)
+				wl_surface_damage_buffer(m_surface, region.x, region.y, region.width, region.height);
+			wl_surface_commit(m_surface);
+			buffer.isBusy = true;
+			// only a committed frame becomes the one the next present is compared with
+			std::swap(m_state->tileHashes, m_state->pendingTileHashes);
+		}
+
+		if (m_state->frameWriter == nullptr || m_state->presentCount++ % m_state->captureInterval != 0)
+			return {};
+		lw::Failable writeResult {m_state->frameWriter->write(
+			std::span<const std::byte> {buffer.data.data(), buffer.data.size()},
+			&buffer
+		)};
+		if (!writeResult)
+			return lw::pushToErrorStack(writeResult, "Can't capture presented frame of window '{}'", m_state->name);
+		buffer.isBeingCaptured = true;
+		return {};
+	}
+
+
+	auto Window::isFramePending() const noexcept -> bool {
+		return m_state->frameCallback != nullptr;
+	}
+
+
+	auto Window::getDamagedTileCount() const noexcept -> std::size_t {
+		return m_state->damagedTileCount;
+	}
+
+
+	auto Window::trim() noexcept -> void {
+		// a failed write is reported again by the next `present` or `stopCapture`
+		static_cast<void> (Window::s_collectCapturedBuffers(*m_state));
+		Window::s_trimBuffers(*m_state);
+	}
+
+
+	auto Window::getMemoryStatistics() const noexcept -> lw::MemoryStatistics {
+		return m_state->memoryStatistics;
+	}
+
+
+	auto Window::setCursorShape(lw::CursorShape shape) noexcept -> lw::Failable<void> {
+		m_state->cursorShape = shape;
+		internals::InstanceState& instanceState {m_state->instance};
+		if (instanceState.pointerFocus != m_surface.get())
+			return {};
+
+		lw::Failable result {internals::setCursorShape(instanceState, instanceState.pointerEnterSerial, shape)};
+		if (!result)
+			return lw::pushToErrorStack(result, "Can't set cursor shape of the focused window");
+		return {};
+	}
+
+
+	auto Window::startCapture(const CaptureInfos& captureInfos) noexcept -> lw::Failable<void> {
+		if (!m_state->usesSharedMemory)
+			return lw::makeErrorStack("Window '{}' is presented natively, capture it through the graphics API",
+				m_state->name
+			);
+		if (m_state->frameWriter != nullptr)
+			return lw::makeErrorStack("Window '{}' is already being captured", m_state->name);
+		if (captureInfos.frameInterval == 0)
+			return lw::makeErrorStack("Capture frame interval must be at least 1");
+
+		// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+		decltype(internals::WindowState::frameWriter) frameWriter {new internals::FrameWriter{}};
+		lw::Failable openResult {frameWriter->open(captureInfos.path)};
+		if (!openResult)
+			return lw::pushToErrorStack(openResult, "Can't start capture of window '{}'", m_state->name);
+		m_state->frameWriter = std::move(frameWriter);
+		m_state->captureInterval = captureInfos.frameInterval;
+		m_state->presentCount = 0;
+		return {};
+	}
+
+
+	auto Window::stopCapture() noexcept -> lw::Failable<void> {
+		if (m_state->frameWriter == nullptr)
+			return {};
+		// closing waits for every pending write, after which no buffer is being captured anymore
+		lw::Failable closeResult {m_state->frameWriter->close()};
+		m_state->frameWriter.reset();
+		for (auto& buffer : m_state->buffers)
+			buffer->isBeingCaptured = false;
+		if (!closeResult)
+			return lw::pushToErrorStack(closeResult, "Can't finish capture of window '{}'", m_state->name);
+		return {};
+	}
+
+
+	auto Window::isCapturing() const noexcept -> bool {
+		return m_state->frameWriter != nullptr;
+	}
+
+
+	auto Window::handleToplevelConfigure(
+		void* data,
+		[[maybe_unused]] xdg_toplevel* toplevel,
+		[[maybe_unused]] std::int32_t width,
+		[[maybe_unused]] std::int32_t height,
+		wl_array* states
+	) noexcept -> void {
+		auto& state {*static_cast<internals::WindowState*> (data)};
+		const std::span<const std::uint32_t> statesView {
+			static_cast<const std::uint32_t*> (states->data),
+			states->size / sizeof(std::uint32_t)
+		};
+		state.isSuspended = std::ranges::contains(statesView, XDG_TOPLEVEL_STATE_SUSPENDED);
+		if (state.isSuspended)
+			Window::s_trimBuffers(state);
+	}
+
+
+	auto Window::handleBufferRelease(void* data, [[maybe_unused]] wl_buffer* buffer) noexcept -> void {
+		auto& releasedBuffer {*static_cast<internals::Buffer*> (data)};
+		releasedBuffer.isBusy = false;
+		if (releasedBuffer.window.isSuspended)
+			Window::s_trimBuffers(releasedBuffer.window);
+	}
+
+
+	auto Window::handleFrameDone(
+		void* data,
+		[[maybe_unused]] wl_callback* callback,
+		[[maybe_unused]] std::uint32_t time
+	) noexcept -> void {
+		lw::trace::instant("Window::frameDone");
+		auto& state {*static_cast<internals::WindowState*> (data)};
+		wl_callback_destroy(state.frameCallback.release());
+	}
+
+
 	auto Window::s_createAnonymousFile(std::string_view name, std::size_t size) noexcept -> lw::Failable<int> {
 		using namespace std::string_view_literals;
 		const std::string_view postfix {"-liteway-wayland-XXXXXX"};
@@ -132,6 +428,7 @@ namespace lw::wayland {
 		wl_shm* sharedMemory,
 		std::uint32_t width, std::uint32_t height
 	) noexcept -> lw::Failable<std::pair<lw::Owned<wl_buffer*>, lw::OwnedSpan<std::byte>>> {
+		const lw::trace::Scope traceScope {"Window::createBuffer"};
 		constexpr auto surfaceFormat {WL_SHM_FORMAT_ARGB8888};
 		constexpr std::size_t bytesPerPixel {4uz};
 
@@ -144,7 +441,7 @@ namespace lw::wayland {
 		const int fd {*fdWithError};
 		lw::Janitor _ {[fd]() noexcept {close(fd);}};
 
-		const auto bufferData {static_cast<std::byte*> (mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0))};
+		const auto bufferData {static_cast<std::byte*> (mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0))};
 		if (bufferData == MAP_FAILED)
 			return lw::makeErrorStack("Can't map anonymous file : {}", strerror(errno));
 
@@ -160,4 +457,183 @@ namespace lw::wayland {
 			return lw::makeErrorStack("Can't create buffer from shared memory pool");
 		return std::make_pair(lw::Owned{buffer}, lw::OwnedSpan{bufferData, size});
 	}
+
+
+	auto Window::s_acquireBuffer(internals::WindowState& state) noexcept -> lw::Failable<internals::Buffer*> {
+		lw::Failable collectResult {Window::s_collectCapturedBuffers(state)};
+		if (!collectResult)
+			return lw::pushToErrorStack(collectResult, "Can't collect captured buffers");
+		const auto freeBuffer {std::ranges::find_if(state.buffers, [](const auto& buffer) noexcept {
+			return !buffer->isBusy && !buffer->isBeingCaptured;
+		})};
+		if (freeBuffer != state.buffers.end())
+			return freeBuffer->get();
+
+		if (state.buffers.size() >= state.maxBufferCount) {
+			const bool isWaitingForCapture {std::ranges::any_of(state.buffers, [](const auto& buffer) noexcept {
+				return !buffer->isBusy && buffer->isBeingCaptured;
+			})};
+			if (!isWaitingForCapture) {
+				return lw::makeErrorStack("All {} buffers of the swapchain are used by the compositor",
+					state.buffers.size()
+				);
+			}
+			// the disk is slower than the rendering, so it throttles it instead of failing
+			lw::Failable waitResult {state.frameWriter->waitForCompletion()};
+			if (!waitResult)
+				return lw::pushToErrorStack(waitResult, "Can't wait for a buffer to be captured");
+			return Window::s_acquireBuffer(state);
+		}
+
+		internals::InstanceState& instanceState {state.instance};
+		const std::size_t size {static_cast<std::size_t> (state.width) * state.height * 4uz};
+		const auto isOverBudget {[&instanceState, size]() noexcept -> bool {
+			return instanceState.memoryStatistics.mappedBytes + size > instanceState.memoryBudget;
+		}};
+		if (isOverBudget()) {
+			for (internals::WindowState* window : instanceState.windows)
+				Window::s_trimBuffers(*window);
+			// a window always gets its first buffer, otherwise it could never be shown
+			if (!state.buffers.empty() && isOverBudget()) {
+				return lw::makeErrorStack("Can't allocate a {}B buffer without exceeding the memory budget of {}B",
+					size, instanceState.memoryBudget
+				);
+			}
+		}
+
+		lw::Failable bufferWithError {Window::s_createBuffer(
+			state.name,
+			instanceState.sharedMemory,
+			state.width,
+			state.height
+		)};
+		if (!bufferWithError)
+			return lw::pushToErrorStack(bufferWithError, "Can't create buffer for surface");
+		auto& [buffer, bufferData] {*bufferWithError};
+
+		auto& newBuffer {*state.buffers.emplace_back(std::make_unique<internals::Buffer> (internals::Buffer{
+			.window = state,
+			.buffer = std::move(buffer),
+			.data = std::move(bufferData),
+			.poolSize = size,
+			.isBusy = false
+		}))};
+		const lw::MemoryStatistics bufferStatistics {
+			.mappedBytes = newBuffer.data.size(),
+			.bufferCount = 1uz,
+			.poolBytes = newBuffer.poolSize
+		};
+		state.memoryStatistics += bufferStatistics;
+		instanceState.memoryStatistics += bufferStatistics;
+		lw::trace::counter("Mapped bytes", static_cast<std::int64_t> (instanceState.memoryStatistics.mappedBytes));
+
+		if (wl_buffer_add_listener(newBuffer.buffer, &bufferListener, &newBuffer) != 0) {
+			Window::s_destroyBuffer(state, newBuffer);
+			return lw::makeErrorStack("Can't add listener to buffer");
+		}
+		return &newBuffer;
+	}
+
+
+	auto Window::s_destroyBuffer(internals::WindowState& state, internals::Buffer& buffer) noexcept -> void {
+		const lw::MemoryStatistics bufferStatistics {
+			.mappedBytes = buffer.data.size(),
+			.bufferCount = 1uz,
+			.poolBytes = buffer.poolSize
+		};
+		if (buffer.buffer != nullptr) {
+			state.memoryStatistics -= bufferStatistics;
+			state.instance.memoryStatistics -= bufferStatistics;
+			lw::trace::counter("Mapped bytes", static_cast<std::int64_t> (state.instance.memoryStatistics.mappedBytes));
+		}
+
+		if (!buffer.data.empty())
+			munmap(buffer.data.data(), buffer.data.size());
+		if (buffer.buffer != nullptr)
+			wl_buffer_destroy(buffer.buffer.release());
+		if (state.backBuffer == &buffer)
+			state.backBuffer = nullptr;
+		std::erase_if(state.buffers, [&buffer](const auto& ownedBuffer) noexcept {
+			return ownedBuffer.get() == &buffer;
+		});
+	}
+
+
+	auto Window::s_trimBuffers(internals::WindowState& state) noexcept -> void {
+		// buffers are scanned from the back so the oldest released one is kept for the next frame
+		for (std::size_t i {state.buffers.size()}; i > 0 && state.buffers.size() > 1; --i) {
+			internals::Buffer& buffer {*state.buffers[i - 1]};
+			if (!buffer.isBusy && !buffer.isBeingCaptured && &buffer != state.backBuffer)
+				Window::s_destroyBuffer(state, buffer);
+		}
+	}
+
+
+	auto Window::s_collectCapturedBuffers(internals::WindowState& state) noexcept -> lw::Failable<void> {
+		if (state.frameWriter == nullptr || state.frameWriter->getPendingWriteCount() == 0)
+			return {};
+		std::vector<void*> capturedBuffers {};
+		lw::Failable collectResult {state.frameWriter->collectCompleted(capturedBuffers)};
+		for (void* buffer : capturedBuffers)
+			static_cast<internals::Buffer*> (buffer)->isBeingCaptured = false;
+		if (!collectResult)
+			return lw::pushToErrorStack(collectResult, "Can't collect completed capture writes");
+		return {};
+	}
+
+
+	auto Window::s_findDamagedTiles(internals::WindowState& state, const internals::Buffer& buffer) noexcept -> void {
+		const lw::trace::Scope traceScope {"Window::findDamagedTiles"};
+		const std::uint32_t tileSize {state.damageTileSize};
+		const std::uint32_t columnCount {(state.width + tileSize - 1) / tileSize};
+		const std::uint32_t rowCount {(state.height + tileSize - 1) / tileSize};
+		const std::span<std::uint32_t> pixels {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			reinterpret_cast<std::uint32_t*> (buffer.data.data()),
+			buffer.data.size() >> 2uz
+		};
+		// the first frame has nothing to be compared with and damages everything
+		const bool isFirstFrame {state.tileHashes.empty()};
+		state.pendingTileHashes.resize(static_cast<std::size_t> (columnCount) * rowCount);
+		state.damageRegions.clear();
+		state.damagedTileCount = 0;
+
+		for (std::uint32_t row {0}; row < rowCount; ++row) {
+			const std::uint32_t y {row * tileSize};
+			const std::uint32_t height {std::min(tileSize, state.height - y)};
+			for (std::uint32_t column {0}; column < columnCount; ++column) {
+				const std::uint32_t x {column * tileSize};
+				const std::uint32_t width {std::min(tileSize, state.width - x)};
+				const std::uint64_t hash {lw::hashImage({
+					.pixels = pixels.subspan(static_cast<std::size_t> (y) * state.width + x),
+					.width = width,
+					.height = height,
+					.stride = state.width
+				})};
+				const std::size_t tileIndex {static_cast<std::size_t> (row) * columnCount + column};
+				state.pendingTileHashes[tileIndex] = hash;
+				if (!isFirstFrame && hash == state.tileHashes[tileIndex])
+					continue;
+				++state.damagedTileCount;
+
+				// changed tiles next to each other on a row are merged into a single damage request
+				const auto regionX {static_cast<std::int32_t> (x)};
+				const auto regionY {static_cast<std::int32_t> (y)};
+				if (!state.damageRegions.empty()) {
+					internals::DamageRegion& lastRegion {state.damageRegions.back()};
+					if (lastRegion.y == regionY && lastRegion.x + lastRegion.width == regionX) {
+						lastRegion.width += static_cast<std::int32_t> (width);
+						continue;
+					}
+				}
+				state.damageRegions.push_back({
+					.x = regionX,
+					.y = regionY,
+					.width = static_cast<std::int32_t> (width),
+					.height = static_cast<std::int32_t> (height)
+				});
+			}
+		}
+		lw::trace::counter("Damaged tiles", static_cast<std::int64_t> (state.damagedTileCount));
+	}
 }